@@ -20,497 +20,1288 @@
   The security evaluations might not be the best, please feel free to submit a pull request
   (or just change it on your local copy) if you believe you can tune them better.
 
-  Requires OpenSSL >=3.0
+  Requires OpenSSL >=3.0 (and -pthread for the --search mode)
 */
 
 #include <iostream>
 #include <iomanip>
 #include <vector>
-#include <openssl/sha.h>
-
-#ifdef DEBUG
-#include <numeric>
-#include <set>
-#include <map>
 #include <string>
 #include <cstring>
 #include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <array>
+#include <fstream>
+#include <cstdio>
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+#include "sboxKernel.h"
+
+// ------------------- GF(2^8) Arithmetic -------------------
 
-// ----- Extended Differential Uniformity Analysis -----
+// Multiply two numbers in GF(2^8) using the irreducible polynomial 0x11B (bit loop; only used to build the tables below).
+constexpr uint8_t gfMultiplySlow(uint8_t a, uint8_t b) {
+    uint8_t p = 0;
+    for (int i = 0; i < 8; i++) {
+        if (b & 1)
+            p ^= a;
+        bool hi_bit_set = (a & 0x80);
+        a <<= 1;
+        if (hi_bit_set)
+            a ^= 0x1B;
+        b >>= 1;
+    }
+    return p;
+}
 
-struct DifferentialStats {
-    int maxCount;
-    double average;
-    double stdDeviation;
-    std::vector<int> histogram; // histogram: index = differential count, value = frequency
+// Log/antilog/inverse tables for GF(2^8) mod 0x11B, built at compile time.
+// 0x03 generates the multiplicative group, so exp[i] = 0x03^i and log[exp[i]] = i. exp is doubled (510 entries)
+// so that exp[log[a] + log[b]] needs no reduction mod 255.
+struct GFTables {
+    uint8_t exp[512] = {};
+    uint8_t log[256] = {};
+    uint8_t inv[256] = {}; // inv[0] = 0 by definition
 };
 
-DifferentialStats calculateExtendedDifferentialStats(const uint8_t sbox[256]) {
-    int totalEntries = 255 * 256; // excluding a = 0
-    std::vector<int> counts;
-    counts.reserve(totalEntries);
-    int maxCount = 0;
-    
-    for (int a = 1; a < 256; a++) {
-        int diffCounts[256] = {0};
-        for (int x = 0; x < 256; x++) {
-            int y = sbox[x] ^ sbox[x ^ a];
-            diffCounts[y]++;
-        }
-        for (int y = 0; y < 256; y++) {
-            counts.push_back(diffCounts[y]);
-            if (diffCounts[y] > maxCount)
-                maxCount = diffCounts[y];
-        }
-    }
-    
-    double sum = std::accumulate(counts.begin(), counts.end(), 0.0);
-    double avg = sum / counts.size();
-    double variance = 0.0;
-    for (int v : counts) {
-        variance += (v - avg) * (v - avg);
-    }
-    variance /= counts.size();
-    double stdDev = std::sqrt(variance);
-    
-    // Build histogram for counts from 0 to maxCount.
-    std::vector<int> histogram(maxCount + 1, 0);
-    for (int v : counts) {
-        histogram[v]++;
+constexpr GFTables buildGFTables() {
+    GFTables t;
+    uint8_t value = 1;
+    for (int i = 0; i < 255; i++) {
+        t.exp[i] = value;
+        t.exp[i + 255] = value;
+        t.log[value] = static_cast<uint8_t>(i);
+        value = gfMultiplySlow(value, 0x03);
     }
-    
-    DifferentialStats stats { maxCount, avg, stdDev, histogram };
-    return stats;
-}
-
-// ----- Extended Walsh Analysis for a Boolean Function -----
-// Compute the full Walsh coefficients for a Boolean function f: {0,1}^8 -> {0,1}
-std::vector<int> computeFullWalshCoefficients(const int f[256]) {
-    std::vector<int> walshCoeffs;
-    walshCoeffs.reserve(255);
-    for (int a = 1; a < 256; a++) {
-        int sum = 0;
-        for (int x = 0; x < 256; x++) {
-            int dot = 0;
-            int temp = a & x;
-            while (temp) {
-                dot ^= (temp & 1);
-                temp >>= 1;
-            }
-            int sign = ((f[x] ^ dot) == 0) ? 1 : -1;
-            sum += sign;
-        }
-        walshCoeffs.push_back(sum);
-    }
-    return walshCoeffs;
+    for (int x = 1; x < 256; x++)
+        t.inv[x] = t.exp[255 - t.log[x]]; // x^-1 = 0x03^(255 - log x)
+    return t;
 }
 
-struct WalshStats {
-    int maxAbs;
-    double averageAbs;
-    double stdDeviationAbs;
-};
+constexpr GFTables GF = buildGFTables();
 
-WalshStats calculateWalshStats(const int f[256]) {
-    std::vector<int> walshCoeffs = computeFullWalshCoefficients(f);
-    std::vector<int> absCoeffs;
-    absCoeffs.reserve(walshCoeffs.size());
-    for (int val : walshCoeffs) {
-        absCoeffs.push_back(std::abs(val));
-    }
-    int maxAbs = *std::max_element(absCoeffs.begin(), absCoeffs.end());
-    double sumAbs = std::accumulate(absCoeffs.begin(), absCoeffs.end(), 0.0);
-    double avgAbs = sumAbs / absCoeffs.size();
-    double variance = 0.0;
-    for (int v : absCoeffs) {
-        variance += (v - avgAbs) * (v - avgAbs);
-    }
-    variance /= absCoeffs.size();
-    double stdDevAbs = std::sqrt(variance);
-    
-    return { maxAbs, avgAbs, stdDevAbs };
+// Checks against FIPS-197 (4.2 multiplication example, and the inverse used in the AES S-box derivation).
+static_assert(gfMultiplySlow(0x57, 0x83) == 0xC1, "GF(2^8) multiplication is wrong");
+static_assert(GF.inv[0x53] == 0xCA && GF.inv[0xCA] == 0x53, "GF(2^8) inverse table is wrong");
+
+// Multiply two numbers in GF(2^8) (0x11B) with two log lookups and one antilog lookup.
+constexpr uint8_t gfMultiply(uint8_t a, uint8_t b) {
+    if (a == 0 || b == 0)
+        return 0;
+    return GF.exp[GF.log[a] + GF.log[b]];
 }
 
-// ----- Algebraic Degree Analysis -----
-// Compute the algebraic degree of a Boolean function f given its truth table (256 values).
-// We use a Möbius transform to compute the Algebraic Normal Form (ANF) coefficients.
-int computeAlgebraicDegree(const int f[256]) {
-    int coeff[256];
-    for (int i = 0; i < 256; i++) {
-        coeff[i] = f[i];
+// Compute the multiplicative inverse in GF(2^8); define inverse(0)=0.
+constexpr uint8_t multiplicativeInverse(uint8_t x) {
+    return GF.inv[x];
+}
+
+// ------------------- Key-Dependent Affine Transformation -------------------
+
+// Parity (XOR of all bits) of a byte, by folding.
+constexpr uint8_t parity8(uint8_t v) {
+    v ^= v >> 4;
+    v ^= v >> 2;
+    v ^= v >> 1;
+    return v & 1;
+}
+
+// Compute the affine transform on an 8-bit value using a key-dependent 8x8 matrix A and vector b.
+// The matrix A is provided as an array of 8 uint8_t values (each representing a row).
+constexpr uint8_t affineTransform(uint8_t y, const uint8_t A[8], uint8_t b) {
+    uint8_t result = 0;
+    for (int i = 0; i < 8; i++)
+        result |= static_cast<uint8_t>(parity8(A[i] & y) << i); // Bit i = <row i, y> mod 2
+    return result ^ b;
+}
+
+// Tabulate the linear part of the affine transform: since y -> A*y is linear over GF(2), each entry is the entry
+// without its lowest set bit XOR the matrix column for that bit, so the whole table costs 255 XORs.
+void buildAffineTable(const uint8_t A[8], uint8_t b, uint8_t table[256]) {
+    uint8_t columns[8];
+    for (int j = 0; j < 8; j++)
+        columns[j] = affineTransform(static_cast<uint8_t>(1 << j), A, 0);
+    table[0] = 0;
+    for (int y = 1; y < 256; y++) {
+        int low = 0;
+        while (!((y >> low) & 1))
+            low++;
+        table[y] = table[y & (y - 1)] ^ columns[low];
     }
-    // Möbius transform (in-place)
+    for (int y = 0; y < 256; y++)
+        table[y] ^= b;
+}
+
+// ------------------- Key Material to Matrix and Vector -------------------
+
+// Check if an 8x8 binary matrix (represented as 8 bytes, one row each) is invertible over GF(2).
+bool isInvertible(uint8_t A[8]) {
+    // Make a copy for Gaussian elimination.
+    uint8_t M[8];
+    memcpy(M, A, 8);
+    // Perform Gaussian elimination mod 2.
     for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 256; j++) {
-            if (j & (1 << i)) {
-                coeff[j] ^= coeff[j ^ (1 << i)];
+        // Find pivot: bit i in row >= i should be 1.
+        bool pivotFound = false;
+        for (int j = i; j < 8; j++) {
+            if ( (M[j] >> i) & 1 ) {
+                // Swap rows i and j if needed.
+                if(j != i) {
+                    uint8_t temp = M[i];
+                    M[i] = M[j];
+                    M[j] = temp;
+                }
+                pivotFound = true;
+                break;
             }
         }
-    }
-    int maxDegree = 0;
-    for (int j = 0; j < 256; j++) {
-        if (coeff[j] != 0) {
-            int degree = 0;
-            int temp = j;
-            while (temp) {
-                degree += (temp & 1);
-                temp >>= 1;
+        if (!pivotFound)
+            return false;
+        // Eliminate the pivot bit from all other rows.
+        for (int j = 0; j < 8; j++) {
+            if (j != i && ((M[j] >> i) & 1)) {
+                M[j] ^= M[i];
             }
-            if (degree > maxDegree)
-                maxDegree = degree;
         }
     }
-    return maxDegree;
+    return true;
 }
 
-// ----- Extended S-Box Analysis -----
-// For each output bit of the S-box, compute nonlinearity, Walsh stats, and algebraic degree.
-struct SBoxAnalysis {
-    int minNonlinearity;
-    int maxNonlinearity;
-    double avgNonlinearity;
-    int minAlgebraicDegree;
-    int maxAlgebraicDegree;
-	int differentialUniformity;
-	double stdDevDifferentialDistribution;
-};
+// Reusable SHA-256 context for hashing many keys: the digest implementation is fetched once and the context is
+// only reset between keys, where the one-shot SHA256() sets both up again for every call. One per thread.
+class Sha256Context {
+public:
+    Sha256Context() : md(EVP_MD_fetch(nullptr, "SHA256", nullptr)), ctx(EVP_MD_CTX_new()) {
+        if (!md || !ctx) {
+            std::cerr << "Failed to initialize SHA-256." << std::endl;
+            exit(1);
+        }
+    }
+    ~Sha256Context() {
+        EVP_MD_CTX_free(ctx);
+        EVP_MD_free(md);
+    }
+    Sha256Context(const Sha256Context&) = delete;
+    Sha256Context& operator=(const Sha256Context&) = delete;
 
-int nonlinearity(const int sbox[256]) {
-    int min_nonlinearity = 256; // start with a high number
+    void digest(const uint8_t* data, size_t size, unsigned char hash[SHA256_DIGEST_LENGTH]) {
+        EVP_DigestInit_ex(ctx, md, nullptr);
+        EVP_DigestUpdate(ctx, data, size);
+        EVP_DigestFinal_ex(ctx, hash, nullptr);
+    }
 
-    for (int affine = 0; affine < 256; affine++) {
-        int distance = 0;
-        for (int x = 0; x < 256; x++) {
-            int y1 = sbox[x];
-            int y2 = (x ^ affine); // affine approximation
-            distance += (y1 != y2);
-        }
-        min_nonlinearity = std::min(min_nonlinearity, distance);
+private:
+    EVP_MD* md;
+    EVP_MD_CTX* ctx;
+};
+
+// Generate an invertible 8x8 matrix (A) and an 8-bit vector (b) from the SHA-256 digest of a key.
+// If the candidate matrix is not invertible, we tweak one row. Returns false if no invertible matrix could be derived.
+// If tweaks is given, it receives the number of row tweaks that were needed (16 when the key failed).
+bool deriveAffineParameters(const unsigned char hash[SHA256_DIGEST_LENGTH], uint8_t A[8], uint8_t &b, int* tweaks = nullptr) {
+    // Use first 8 bytes as candidate rows for A.
+    for (int i = 0; i < 8; i++) {
+        A[i] = hash[i];
+        if (A[i] == 0) A[i] = 1;  // Avoid zero row.
     }
+    
+    // If the matrix is not invertible, tweak rows until it is. The tweaks cycle after 16 attempts (every row has
+    // been flipped twice, restoring the original matrix), so trying longer cannot succeed.
+    int attempt = 0;
+    while (!isInvertible(A) && attempt < 16) {
+        // Simple tweak: XOR one row with a constant.
+        A[attempt % 8] ^= 0xFF;
+        attempt++;
+    }
+    if (tweaks)
+        *tweaks = attempt;
+    if (!isInvertible(A))
+        return false;
+    
+    // Use the 9th byte of the hash as b (if zero, set to a nonzero value).
+    b = hash[8];
+    if (b == 0)
+        b = 0x63; // Fall back to AES constant.
+    return true;
+}
 
-    return min_nonlinearity;
+// Generate the affine parameters from a key, hashing it with SHA-256 first.
+bool generateKeyDependentAffineParameters(const std::vector<uint8_t>& key, uint8_t A[8], uint8_t &b) {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(key.data(), key.size(), hash);
+    return deriveAffineParameters(hash, A, b);
 }
 
+// ------------------- Key-Dependent S-box Generation -------------------
 
-int differential_uniformity(const int sbox[256]) {
-    std::map<int, int> output_counts;
-    int max_count = 0;
+// Generate the keyed S-box. For each input x (0..255):
+// If x is 0, define Inv(x)=0; otherwise, compute the multiplicative inverse in GF(2^8).
+// Then apply the key-dependent affine transformation. Returns false if the key yields no invertible matrix.
+// This overload takes the SHA-256 digest of the key, for callers that hash keys with a reused Sha256Context.
+bool generateKeyedSBox(const unsigned char keyDigest[SHA256_DIGEST_LENGTH], uint8_t sbox[256]) {
+    uint8_t A[8];
+    uint8_t b;
+    if (!deriveAffineParameters(keyDigest, A, b))
+        return false;
 
-    for (int input_diff = 0; input_diff < 256; input_diff++) {
-        for (int x = 0; x < 256; x++) {
-            int y1 = sbox[x];
-            int y2 = sbox[x ^ input_diff];
-            int output_diff = y1 ^ y2;
-            output_counts[output_diff]++;
-        }
-    }
+    uint8_t affine[256];
+    buildAffineTable(A, b, affine);
+    for (int x = 0; x < 256; x++)
+        sbox[x] = affine[GF.inv[x]]; // Two lookups per entry (inverse, then affine)
+    return true;
+}
 
-    for (const auto& entry : output_counts) {
-        max_count = std::max(max_count, entry.second);
+bool generateKeyedSBox(const std::vector<uint8_t>& key, uint8_t sbox[256]) {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(key.data(), key.size(), hash);
+    return generateKeyedSBox(hash, sbox);
+}
+
+// ------------------- Inverse S-box and SIMD Tables -------------------
+
+// Invert an 8x8 binary matrix (rows as bytes, as in affineTransform) by Gauss-Jordan elimination over GF(2).
+// Returns false if the matrix is singular.
+bool invertMatrix(const uint8_t A[8], uint8_t inverse[8]) {
+    uint8_t M[8];
+    memcpy(M, A, 8);
+    for (int i = 0; i < 8; i++)
+        inverse[i] = static_cast<uint8_t>(1 << i); // Identity; receives the same row operations as M
+    for (int i = 0; i < 8; i++) {
+        int pivot = i;
+        while (pivot < 8 && !((M[pivot] >> i) & 1))
+            pivot++;
+        if (pivot == 8)
+            return false;
+        std::swap(M[i], M[pivot]);
+        std::swap(inverse[i], inverse[pivot]);
+        for (int j = 0; j < 8; j++) {
+            if (j != i && ((M[j] >> i) & 1)) {
+                M[j] ^= M[i];
+                inverse[j] ^= inverse[i];
+            }
+        }
     }
+    return true;
+}
 
-    return max_count; // Return the maximum count of differential output differences
+// Pack a matrix into the GF2P8AFFINEQB operand layout, where byte 7 - i of the qword holds row i.
+uint64_t gfniMatrix(const uint8_t A[8]) {
+    uint64_t packed = 0;
+    for (int i = 0; i < 8; i++)
+        packed |= static_cast<uint64_t>(A[i]) << (8 * (7 - i));
+    return packed;
 }
 
-double differential_distribution(const int sbox[256]) {
-    std::vector<int> dist(256, 0); // to store counts for each output difference
+// Fill every table of sboxKernel.h for the key with the given SHA-256 digest. Returns false if the key yields no
+// invertible matrix.
+bool buildKeyedSBoxTables(const unsigned char keyDigest[SHA256_DIGEST_LENGTH], KeyedSBoxTables& t) {
+    uint8_t A[8], inverseA[8];
+    uint8_t b;
+    if (!deriveAffineParameters(keyDigest, A, b) || !invertMatrix(A, inverseA))
+        return false;
+    uint8_t inverseB = affineTransform(b, inverseA, 0);
 
-    for (int input_diff = 0; input_diff < 256; input_diff++) {
-        for (int x = 0; x < 256; x++) {
-            int y1 = sbox[x];
-            int y2 = sbox[x ^ input_diff];
-            int output_diff = y1 ^ y2;
-            dist[output_diff]++;
+    uint8_t affine[256];
+    buildAffineTable(A, b, affine);
+    for (int x = 0; x < 256; x++) {
+        t.sbox[x] = affine[GF.inv[x]];
+        t.inverse[t.sbox[x]] = static_cast<uint8_t>(x);
+    }
+    for (int n = 0; n < 16; n++) {
+        t.affineLow[n] = affine[n];
+        t.affineHigh[n] = affine[n << 4] ^ b;
+        t.inverseAffineLow[n] = affineTransform(static_cast<uint8_t>(n), inverseA, inverseB);
+        t.inverseAffineHigh[n] = affineTransform(static_cast<uint8_t>(n << 4), inverseA, 0);
+    }
+    t.gfniMatrix = gfniMatrix(A);
+    t.gfniConstant = b;
+    t.gfniInverseMatrix = gfniMatrix(inverseA);
+    t.gfniInverseConstant = inverseB;
+    return true;
+}
+
+// Run every kernel the CPU supports over all byte values (at several offsets, so the vector bodies and the scalar
+// tails are both covered) and check it against the tables, forwards and backwards. Prints the result per kernel.
+bool checkSBoxKernels(const KeyedSBoxTables& t) {
+    static const char* const NAMES[] = {"scalar", "ssse3", "avx2", "gfni"};
+    std::vector<uint8_t> input(256 * 16 + 31), forward(input.size()), backward(input.size());
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<uint8_t>(i * 167 + (i >> 8));
+    bool ok = true;
+    std::cout << "Kernel self-check:";
+    for (int k = 0; k <= static_cast<int>(bestSBoxKernel()); k++) {
+        SBoxKernel kernel = static_cast<SBoxKernel>(k);
+        bool kernelOk = true;
+        for (size_t offset = 0; offset < 32 && kernelOk; offset += 7) {
+            size_t size = input.size() - offset;
+            substituteBytes(t, input.data() + offset, forward.data(), size, kernel);
+            inverseSubstituteBytes(t, forward.data(), backward.data(), size, kernel);
+            for (size_t i = 0; i < size; i++) {
+                if (forward[i] != t.sbox[input[offset + i]] || backward[i] != input[offset + i]) {
+                    kernelOk = false;
+                    break;
+                }
+            }
         }
+        std::cout << " " << NAMES[k] << (kernelOk ? " ok" : " FAILED");
+        ok = ok && kernelOk;
     }
+    std::cout << std::endl;
+    return ok;
+}
+
+// ------------------- S-box Analysis Engine -------------------
+
+// Number of set bits in a byte.
+constexpr int popcount8(uint8_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(v);
+#else
+    v = v - ((v >> 1) & 0x55);
+    v = (v & 0x33) + ((v >> 2) & 0x33);
+    return (v + (v >> 4)) & 0x0F;
+#endif
+}
 
-    double sum = 0.0;
-    for (int count : dist) {
-        sum += count;
+// One butterfly of the fast Walsh-Hadamard transform applied to 256 independent lanes: (u, w) -> (u + w, u - w).
+// The pointers never alias, which lets the compiler vectorize the loop without runtime overlap checks.
+inline void walshButterfly(int16_t* __restrict u, int16_t* __restrict w) {
+    for (int i = 0; i < 256; i++) {
+        int16_t p = u[i];
+        int16_t q = w[i];
+        u[i] = static_cast<int16_t>(p + q);
+        w[i] = static_cast<int16_t>(p - q);
     }
-    double average = sum / dist.size();
+}
+
+// In-place fast Walsh-Hadamard transform over the row index of a 256x256 matrix, i.e. of all 256 columns at once:
+// 8 stages of 128 butterflies, each a contiguous 256-lane vector operation.
+inline void fastWalshHadamard(int16_t* matrix) {
+    for (int h = 1; h < 256; h <<= 1)
+        for (int i = 0; i < 256; i += h << 1)
+            for (int j = i; j < i + h; j++)
+                walshButterfly(&matrix[j * 256], &matrix[(j + h) * 256]);
+}
 
-    double variance = 0.0;
-    for (int count : dist) {
-        variance += (count - average) * (count - average);
+// Running maximum of |row[i]| into peak[i], lane by lane.
+inline void accumulatePeak(int16_t* __restrict peak, const int16_t* __restrict row) {
+    for (int i = 0; i < 256; i++) {
+        int16_t v = static_cast<int16_t>(row[i] < 0 ? -row[i] : row[i]);
+        peak[i] = v > peak[i] ? v : peak[i];
     }
-    double stddev = std::sqrt(variance / dist.size());
+}
 
-    std::cout << "Differential Distribution: Average = " << average << ", Std Dev = " << stddev << std::endl;
-    return stddev;
+// Sylvester-Hadamard matrix: hadamardMatrix()[y * 256 + b] = (-1)^popcount(y & b), built on first use.
+const int16_t* hadamardMatrix() {
+    static const std::vector<int16_t> matrix = [] {
+        std::vector<int16_t> m(256 * 256);
+        for (int y = 0; y < 256; y++)
+            for (int b = 0; b < 256; b++)
+                m[y * 256 + b] = static_cast<int16_t>(1 - 2 * (popcount8(static_cast<uint8_t>(y & b)) & 1));
+        return m;
+    }();
+    return matrix.data();
 }
 
+// In-place Moebius transform (truth table -> ANF) of all 8 coordinate functions at once: bit i of v[u] is the
+// coefficient of the monomial x^u in output bit i.
+inline void moebiusTransform(uint8_t v[256]) {
+    for (int h = 1; h < 256; h <<= 1)
+        for (int i = 0; i < 256; i += h << 1)
+            for (int j = i; j < i + h; j++)
+                v[j + h] ^= v[j];
+}
+
+// Summary of an S-box's cryptographic properties. Nonlinearity and degree are taken over all 255 component
+// functions b.S(x), b != 0, not just the 8 output bits, since a weak linear combination is as exploitable as a weak bit.
+struct SBoxAnalysis {
+    int differentialUniformity;            // Max DDT entry over nonzero input differences (4 is optimal for 8 bits)
+    double averageDifferential;            // Mean DDT entry over nonzero input differences (always 1 for a permutation)
+    double stdDevDifferentialDistribution; // Spread of those DDT entries
+    int linearity;                         // Max |Walsh coefficient| over nonzero output masks (32 for the AES S-box)
+    int minNonlinearity;
+    int maxNonlinearity;
+    double avgNonlinearity;
+    int minAlgebraicDegree;
+    int maxAlgebraicDegree;
+};
 
-SBoxAnalysis analyzeSBox(const uint8_t sbox[256]) {
-    int totalNL = 0;
-    int minNL = 256, maxNL = 0;
-    int totalDegree = 0;
-    int minDegree = 8, maxDegree = 0;
+// Builds the difference distribution table and the linear approximation (Walsh) table of an S-box once, into flat
+// arrays that are reused between calls, and derives every metric from them. Scoring a candidate costs half a pass of
+// DDT increments and one vectorized 256x256 FWHT, with no allocation, so an analyzer can be kept per thread and fed
+// millions of candidates.
+class SBoxAnalyzer {
+public:
+    SBoxAnalyzer() : ddtTable(256 * 256), latTable(256 * 256) {}
+
+    // ddt()[a * 256 + b] = #{x : S(x) ^ S(x ^ a) = b}
+    const uint16_t* ddt() const { return ddtTable.data(); }
+    // lat()[a * 256 + b] = sum over x of (-1)^(b.S(x) ^ a.x); column b is the Walsh spectrum of component b
+    const int16_t* lat() const { return latTable.data(); }
+
+    SBoxAnalysis analyze(const uint8_t sbox[256]) {
+        SBoxAnalysis result{};
+        analyzeDifferential(sbox, result);
+        analyzeLinear(sbox, result);
+        analyzeDegree(sbox, result);
+        return result;
+    }
 
-	// Compute nonlinearity and algebraic degree (per output bit)
-    for (int bit = 0; bit < 8; bit++) {
-        int f[256];
-        for (int x = 0; x < 256; x++) {
-            f[x] = (sbox[x] >> bit) & 1;
+    // Like analyze(), but stops at the first failed threshold: the DDT (cheapest) is checked against the maximum
+    // differential uniformity before the LAT is built, and the LAT against the minimum nonlinearity before the degree
+    // is computed. Returns false for a rejected S-box, whose result is then only partially filled in.
+    bool screen(const uint8_t sbox[256], int maxDifferentialUniformity, int minNonlinearity, SBoxAnalysis& result) {
+        result = SBoxAnalysis{};
+        analyzeDifferential(sbox, result);
+        if (result.differentialUniformity > maxDifferentialUniformity)
+            return false;
+        analyzeLinear(sbox, result);
+        if (result.minNonlinearity < minNonlinearity)
+            return false;
+        analyzeDegree(sbox, result);
+        return true;
+    }
+
+    // The stages of analyze(), public so that they can be timed separately. Each fills in its own fields of result.
+    void analyzeDifferential(const uint8_t sbox[256], SBoxAnalysis& result) {
+        // Difference distribution table. x and x ^ a land on the same entry, so only visit the x with the top bit of
+        // a clear and count each pair twice.
+        std::fill(ddtTable.begin(), ddtTable.end(), 0);
+        ddtTable[0] = 256;
+        for (int a = 1, top = 1; a < 256; a++) {
+            if (a == top << 1)
+                top = a;
+            uint16_t* row = &ddtTable[a * 256];
+            for (int block = 0; block < 256; block += top << 1)
+                for (int x = block; x < block + top; x++)
+                    row[sbox[x] ^ sbox[x ^ a]] += 2;
         }
-        int nl = nonlinearity(f);
-        totalNL += nl;
-        minNL = std::min(minNL, nl);
-        maxNL = std::max(maxNL, nl);
-        
-        int degree = computeAlgebraicDegree(f);
-        totalDegree += degree;
-        minDegree = std::min(minDegree, degree);
-        maxDegree = std::max(maxDegree, degree);
-    }
-
-	// Compute Differential Distribution Table (DDT)
-	int diffCounts[256] = {0};
-	int totalDiffValues = 0;
-	double sumDiff = 0.0, sumDiffSquared = 0.0;
-	int maxDiffCount = 0;
-
-    // Track unique differential outputs
-    std::set<int> uniqueDiffs; 
-
-    for (int a = 1; a < 256; a++) { // Nonzero input difference
-        int localDiffCounts[256] = {0};
-        for (int x = 0; x < 256; x++) {
-            int y = sbox[x] ^ sbox[x ^ a];
-            localDiffCounts[y]++;
-            uniqueDiffs.insert(y); // Store unique differentials
+        int maxCount = 0;
+        uint64_t sum = 0, sumSquares = 0;
+        for (int i = 256; i < 256 * 256; i++) { // Skip row a = 0
+            int count = ddtTable[i];
+            maxCount = std::max(maxCount, count);
+            sum += count;
+            sumSquares += static_cast<uint64_t>(count) * count;
         }
-        for (int y = 0; y < 256; y++) {
-            diffCounts[y] += localDiffCounts[y];
-            maxDiffCount = std::max(maxDiffCount, localDiffCounts[y]);
+        const double entries = 255.0 * 256.0;
+        double mean = sum / entries;
+        result.differentialUniformity = maxCount;
+        result.averageDifferential = mean;
+        result.stdDevDifferentialDistribution = std::sqrt(std::max(0.0, sumSquares / entries - mean * mean));
+    }
+
+    void analyzeLinear(const uint8_t sbox[256], SBoxAnalysis& result) {
+        // Linear approximation table: row x starts as the sign vector (-1)^(b.S(x)) of every component b, which is
+        // row S(x) of the Hadamard matrix, and one FWHT over x turns each column into its component's Walsh spectrum
+        const int16_t* hadamard = hadamardMatrix();
+        for (int x = 0; x < 256; x++)
+            memcpy(&latTable[x * 256], &hadamard[sbox[x] * 256], 256 * sizeof(int16_t));
+        fastWalshHadamard(latTable.data());
+        int16_t peak[256] = {0};
+        for (int a = 0; a < 256; a++)
+            accumulatePeak(peak, &latTable[a * 256]);
+        int totalNL = 0;
+        result.linearity = 0;
+        result.minNonlinearity = 256;
+        result.maxNonlinearity = 0;
+        for (int b = 1; b < 256; b++) { // Column b = 0 is the constant function
+            int nl = 128 - peak[b] / 2;
+            result.linearity = std::max(result.linearity, static_cast<int>(peak[b]));
+            result.minNonlinearity = std::min(result.minNonlinearity, nl);
+            result.maxNonlinearity = std::max(result.maxNonlinearity, nl);
+            totalNL += nl;
         }
+        result.avgNonlinearity = totalNL / 255.0;
     }
 
-    // Print unique differential values count
-    std::cout << "Unique Differential Outputs: " << uniqueDiffs.size() << std::endl;
+    // Fills in minAlgebraicDegree and maxAlgebraicDegree.
+    void analyzeDegree(const uint8_t sbox[256], SBoxAnalysis& result) {
+        // Algebraic degree. The ANF is linear in the output mask (component b has coefficient parity(b & anf[u]) at
+        // monomial u), so every component has degree >= d exactly when the coefficient vectors anf[u] with
+        // popcount(u) >= d span GF(2)^8; insert them from the highest weight down into an echelon basis.
+        uint8_t anf[256];
+        memcpy(anf, sbox, 256);
+        moebiusTransform(anf);
+        uint8_t basis[8] = {0}; // basis[i] has leading bit i
+        int rank = 0;
+        result.minAlgebraicDegree = 0;
+        result.maxAlgebraicDegree = 0;
+        for (int d = 8; d >= 1 && rank < 8; d--) {
+            for (int u = 1; u < 256; u++) {
+                if (popcount8(static_cast<uint8_t>(u)) != d || !anf[u])
+                    continue;
+                if (!result.maxAlgebraicDegree)
+                    result.maxAlgebraicDegree = d;
+                uint8_t v = anf[u];
+                for (int i = 7; i >= 0 && v; i--) {
+                    if (!((v >> i) & 1))
+                        continue;
+                    if (!basis[i]) {
+                        basis[i] = v;
+                        rank++;
+                        break;
+                    }
+                    v ^= basis[i];
+                }
+            }
+            if (rank == 8)
+                result.minAlgebraicDegree = d;
+        }
+    }
 
-	double meanDiff = (totalDiffValues > 0) ? (sumDiff / totalDiffValues) : 0.0;
-	double varianceDiff = (totalDiffValues > 0) ? ((sumDiffSquared / totalDiffValues) - (meanDiff * meanDiff)) : 0.0;
-	double stdDevDiff = (varianceDiff >= 0) ? std::sqrt(varianceDiff) : 0.0;
+private:
+    std::vector<uint16_t> ddtTable;
+    std::vector<int16_t> latTable;
+};
 
-    std::cout << "Differential Distribution Counts: ";
-    for (int i = 0; i < 16; i++) {
-        std::cout << diffCounts[i] << " ";
-    }
-    std::cout << std::endl;
+// Composite security score of an analysis (1.0 for an S-box matching the AES optimum: DU=4, NL=112, degree 7).
+double securityScore(const SBoxAnalysis& analysis) {
+    double scoreNL = static_cast<double>(analysis.minNonlinearity) / 112.0;
+    double scoreDU = 4.0 / static_cast<double>(analysis.differentialUniformity);
+    double scoreAD = static_cast<double>(analysis.minAlgebraicDegree) / 7.0;
 
-    int SBOX[256];
-    for (size_t i = 0; i < 256; ++i) {
-        SBOX[i] = static_cast<int>(sbox[i]);
-    }
+    // Additional precision factors
+    double scoreDDD = 1.0 / (1.0 + analysis.stdDevDifferentialDistribution);
+    double scoreNLS = 1.0 / (1.0 + (analysis.maxNonlinearity - analysis.minNonlinearity));
 
-	// Populate the structure
-    SBoxAnalysis analysis;
-    analysis.minNonlinearity = minNL;
-    analysis.maxNonlinearity = maxNL;
-    analysis.avgNonlinearity = totalNL / 8.0;
-    analysis.minAlgebraicDegree = minDegree;
-    analysis.maxAlgebraicDegree = maxDegree;
-	analysis.differentialUniformity = differential_uniformity(SBOX);
-	analysis.stdDevDifferentialDistribution = differential_distribution(SBOX);
-    
-	return analysis;
+    return (0.4 * scoreNL) + (0.3 * scoreDU) + (0.2 * scoreAD) + (0.05 * scoreDDD) + (0.05 * scoreNLS);
 }
 
+#ifdef DEBUG
 // ----- Comprehensive S-box Security Report -----
 void printSBoxSecurityReport(const uint8_t sbox[256]) {
-    // Basic metrics
-    int diffUniformity = calculateExtendedDifferentialStats(sbox).maxCount;
-    
-    DifferentialStats dStats = calculateExtendedDifferentialStats(sbox);
-    std::cout << "Differential Uniformity (max count): " << dStats.maxCount << std::endl;
-    std::cout << "Differential Distribution: Average = " << dStats.average
-              << ", Std Dev = " << dStats.stdDeviation << std::endl;
-    
-    // S-box Boolean function analysis
-    SBoxAnalysis analysis = analyzeSBox(sbox);
+    SBoxAnalyzer analyzer;
+    SBoxAnalysis analysis = analyzer.analyze(sbox);
+
+    std::cout << "Differential Uniformity (max count): " << analysis.differentialUniformity << std::endl;
+    std::cout << "Differential Distribution: Average = " << analysis.averageDifferential
+              << ", Std Dev = " << analysis.stdDevDifferentialDistribution << std::endl;
+
+    // Histogram of DDT entries (index = differential count, value = frequency), excluding a = 0
+    std::vector<int> histogram(analysis.differentialUniformity + 1, 0);
+    for (int i = 256; i < 256 * 256; i++)
+        histogram[analyzer.ddt()[i]]++;
+    std::cout << "Differential Spectrum:";
+    for (size_t count = 0; count < histogram.size(); count++)
+        if (histogram[count])
+            std::cout << " " << count << "x" << histogram[count];
+    std::cout << std::endl;
+
+    std::cout << "Linearity (max |Walsh|): " << analysis.linearity << std::endl;
     std::cout << "Min Nonlinearity: " << analysis.minNonlinearity << std::endl;
     std::cout << "Max Nonlinearity: " << analysis.maxNonlinearity << std::endl;
     std::cout << "Avg Nonlinearity: " << analysis.avgNonlinearity << std::endl;
+    std::cout << "Algebraic Degree: Min = " << analysis.minAlgebraicDegree
+              << ", Max = " << analysis.maxAlgebraicDegree << std::endl;
 
-    std::cout << "Differential Uniformity: " << analysis.differentialUniformity << std::endl;
-    //std::cout << "Std Dev Differential Distribution: " << analysis.stdDevDifferentialDistribution << std::endl;
+    std::cout << "Composite S-box Security Score: " << securityScore(analysis) << std::endl;
+}
+#endif
 
-    std::cout << "Algebraic Degree: Min = " << analysis.minAlgebraicDegree
-            << ", Max = " << analysis.maxAlgebraicDegree << std::endl;
+// ------------------- Keyed S-box Search -------------------
 
-    
-    // Composite security score (ideal: DU=4, NL=112)
-    double scoreNL = static_cast<double>(analysis.minNonlinearity) / 112.0;
-    double scoreDU = 4.0 / static_cast<double>(diffUniformity);
-	double scoreAD = static_cast<double>(analysis.minAlgebraicDegree) / 7.0;
+// Parameters of a --search run.
+struct SearchOptions {
+    uint64_t candidates = 0;             // Number of derived keys to try (--search N)
+    size_t top = 10;                     // Number of best candidates kept (--top K)
+    unsigned threads = 0;                // Worker threads (--threads T); 0 = one per core
+    int maxDifferentialUniformity = 256; // Reject candidates above this DU before building the LAT (--max-du D)
+    int minNonlinearity = 0;             // Reject candidates below this nonlinearity before the degree (--min-nl L)
+};
 
-	// Additional precision factors
-    double scoreDDD = 1.0 / (1.0 + analysis.stdDevDifferentialDistribution);
-    double scoreNLS = 1.0 / (1.0 + (analysis.maxNonlinearity - analysis.minNonlinearity));
+struct SearchResult {
+    double score;
+    uint64_t index;
+    SBoxAnalysis analysis;
+};
 
-    std::cout << "ScoreNL: " << scoreNL << ", ScoreDU: " << scoreDU
-          << ", ScoreAD: " << scoreAD << ", ScoreDDD: " << scoreDDD
-          << ", ScoreNLS: " << scoreNLS << std::endl;
+// Ranking of search results: higher score first, then lower index so that runs are reproducible.
+struct BetterResult {
+    bool operator()(const SearchResult& a, const SearchResult& b) const {
+        return a.score != b.score ? a.score > b.score : a.index < b.index;
+    }
+};
 
-	// Composite weighted score
-	double compositeScore = (0.4 * scoreNL) + (0.3 * scoreDU) + (0.2 * scoreAD) +
-	(0.05 * scoreDDD) + (0.05 * scoreNLS);
+// Min-heap on BetterResult: top() is the worst of the kept results.
+using ResultHeap = std::priority_queue<SearchResult, std::vector<SearchResult>, BetterResult>;
 
-    std::cout << "Composite S-box Security Score: " << compositeScore << std::endl;
+// Key of candidate i: the base key followed by "#i", so any result can be regenerated by passing that string as the key.
+std::string candidateKey(const std::string& base, uint64_t index) {
+    return base + "#" + std::to_string(index);
 }
-#endif
 
-// ------------------- GF(2^8) Arithmetic -------------------
+// Generate and score N candidate S-boxes across all cores and return the best K, best first. Workers claim blocks of
+// candidate indices from a shared counter (all candidates cost the same, so this balances as well as per-thread
+// queues with stealing would) and keep a private top-K heap, merged once they finish.
+std::vector<SearchResult> searchKeyedSBoxes(const std::string& baseKey, const SearchOptions& options) {
+    const uint64_t BLOCK = 1024; // Candidates claimed per counter increment
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<uint64_t> next{0}, checked{0}, rejected{0}, failed{0};
+    std::atomic<unsigned> running{threads};
+    ResultHeap best;
+    std::mutex bestMutex;
 
-// Multiply two numbers in GF(2^8) using the irreducible polynomial 0x11B.
-uint8_t gfMultiply(uint8_t a, uint8_t b) {
-    uint8_t p = 0;
-    for (int i = 0; i < 8; i++) {
-        if (b & 1)
-            p ^= a;
-        bool hi_bit_set = (a & 0x80);
-        a <<= 1;
-        if (hi_bit_set)
-            a ^= 0x1B;
-        b >>= 1;
+    auto worker = [&]() {
+        SBoxAnalyzer analyzer;
+        Sha256Context sha256;
+        ResultHeap local;
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        uint8_t sbox[256];
+        for (;;) {
+            uint64_t begin = next.fetch_add(BLOCK);
+            if (begin >= options.candidates)
+                break;
+            uint64_t end = std::min(options.candidates, begin + BLOCK);
+            uint64_t blockRejected = 0, blockFailed = 0;
+            for (uint64_t index = begin; index < end; index++) {
+                std::string keyStr = candidateKey(baseKey, index);
+                sha256.digest(reinterpret_cast<const uint8_t*>(keyStr.data()), keyStr.size(), digest);
+                if (!generateKeyedSBox(digest, sbox)) {
+                    blockFailed++;
+                    continue;
+                }
+                SearchResult result{0.0, index, {}};
+                if (!analyzer.screen(sbox, options.maxDifferentialUniformity, options.minNonlinearity, result.analysis)) {
+                    blockRejected++;
+                    continue;
+                }
+                result.score = securityScore(result.analysis);
+                if (local.size() < options.top) {
+                    local.push(result);
+                } else if (BetterResult()(result, local.top())) {
+                    local.pop();
+                    local.push(result);
+                }
+            }
+            checked += end - begin;
+            rejected += blockRejected;
+            failed += blockFailed;
+        }
+        std::lock_guard<std::mutex> lock(bestMutex);
+        for (; !local.empty(); local.pop()) {
+            if (best.size() < options.top) {
+                best.push(local.top());
+            } else if (BetterResult()(local.top(), best.top())) {
+                best.pop();
+                best.push(local.top());
+            }
+        }
+        running--;
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++)
+        pool.emplace_back(worker);
+
+    // Progress on stderr every 10 seconds, so long runs can be watched without touching stdout.
+    auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    while (running > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastReport < std::chrono::seconds(10))
+            continue;
+        lastReport = now;
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        uint64_t done = checked;
+        std::cerr << "Checked " << done << "/" << options.candidates << " candidates ("
+                  << static_cast<uint64_t>(done / elapsed) << "/s)" << std::endl;
     }
-    return p;
+    for (auto& thread : pool)
+        thread.join();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Checked " << checked << " candidates in " << elapsed << " s with " << threads << " thread(s): "
+              << rejected << " below threshold, " << failed << " without an invertible matrix." << std::endl;
+
+    std::vector<SearchResult> results;
+    for (; !best.empty(); best.pop())
+        results.push_back(best.top());
+    std::reverse(results.begin(), results.end());
+    return results;
 }
 
-// Compute the multiplicative inverse in GF(2^8); define inverse(0)=0.
-uint8_t multiplicativeInverse(uint8_t x) {
-    if (x == 0)
-        return 0;
-    for (int i = 1; i < 256; i++) {
-        if (gfMultiply(x, static_cast<uint8_t>(i)) == 1)
-            return static_cast<uint8_t>(i);
+// ------------------- Batch Generation -------------------
+
+enum class OutputFormat { Text, Binary, Header };
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Parameters of a --batch run.
+struct BatchOptions {
+    const char* input = nullptr;              // Key source (--batch FILE, "-" for stdin)
+    char delimiter = '\n';                    // Key separator; --null switches to NUL-delimited keys
+    OutputFormat format = OutputFormat::Text; // --format text|binary|header
+    unsigned threads = 0;                     // Worker threads (--threads T); 0 = one per core
+};
+
+// Append an S-box in the text format: "0x7f, " entries, 16 per line. Formats by table lookup instead of iostream
+// manipulators, since that used to cost more than generating the S-box.
+void appendSBoxText(std::string& out, const uint8_t sbox[256]) {
+    for (int i = 0; i < 256; i++) {
+        char entry[6] = {'0', 'x', HEX_DIGITS[sbox[i] >> 4], HEX_DIGITS[sbox[i] & 0x0F], ',', ' '};
+        out.append(entry, sizeof(entry));
+        if ((i + 1) % 16 == 0)
+            out.push_back('\n');
     }
-    return 0; // Should not reach here.
 }
 
-// ------------------- Key-Dependent Affine Transformation -------------------
+// Append bytes as a C initializer body ("0x7f, 0xc8, ..."), 16 per line, each line prefixed with indent.
+void appendCBytes(std::string& out, const uint8_t* data, size_t size, const char* indent) {
+    for (size_t i = 0; i < size; i++) {
+        if (i % 16 == 0)
+            out.append(indent);
+        bool lineEnd = (i + 1) % 16 == 0 || i + 1 == size;
+        char entry[6] = {'0', 'x', HEX_DIGITS[data[i] >> 4], HEX_DIGITS[data[i] & 0x0F], ',', ' '};
+        out.append(entry, lineEnd ? 5 : 6); // No trailing space before the newline
+        if (lineEnd)
+            out.push_back('\n');
+    }
+}
 
-// Compute the affine transform on an 8-bit value using a key-dependent 8x8 matrix A and vector b.
-// The matrix A is provided as an array of 8 uint8_t values (each representing a row).
-uint8_t affineTransform(uint8_t y, const uint8_t A[8], uint8_t b) {
-    uint8_t result = 0;
-    for (int i = 0; i < 8; i++) {
-        // Compute the dot product (mod 2) of the i-th row of A and y.
-        uint8_t row = A[i];
-        uint8_t dot = 0;
-        uint8_t temp = row & y;
-        while (temp) {
-            dot ^= (temp & 1);
-            temp >>= 1;
-        }
-        // Set bit i to (dot XOR the i-th bit of b)
-        result |= ((dot ^ ((b >> i) & 1)) << i);
+// Append one generated S-box in the selected format. Binary records are the 32-byte SHA-256 digest of the key
+// followed by the 256 S-box bytes (288 bytes, no framing); the header format emits one initializer per key.
+void appendBatchRecord(std::string& out, OutputFormat format, const std::string& key,
+                       const unsigned char digest[SHA256_DIGEST_LENGTH], const uint8_t sbox[256]) {
+    switch (format) {
+    case OutputFormat::Text:
+        out.append("Key-dependent S-box for \"").append(key).append("\":\n");
+        appendSBoxText(out, sbox);
+        out.push_back('\n');
+        break;
+    case OutputFormat::Binary:
+        out.append(reinterpret_cast<const char*>(digest), SHA256_DIGEST_LENGTH);
+        out.append(reinterpret_cast<const char*>(sbox), 256);
+        break;
+    case OutputFormat::Header:
+        out.append("    {\n        {\n");
+        appendCBytes(out, digest, SHA256_DIGEST_LENGTH, "            ");
+        out.append("        },\n        {\n");
+        appendCBytes(out, sbox, 256, "            ");
+        out.append("        },\n    },\n");
+        break;
     }
-    return result;
 }
 
-// ------------------- Key Material to Matrix and Vector -------------------
+// Read keys from a file or stdin and write one S-box per key to stdout. Keys are processed in chunks: each chunk is
+// split across the worker threads, every worker hashes (with its own reused SHA-256 context), generates and formats
+// its share into a private buffer, and the buffers are written in input order with one fwrite each. Empty keys are
+// skipped; keys that yield no invertible matrix are reported on stderr and skipped. Returns the exit status.
+int runBatch(const BatchOptions& options) {
+    const size_t CHUNK_KEYS = 16384; // Keys read and generated per round
+    std::ifstream file;
+    if (strcmp(options.input, "-") != 0) {
+        file.open(options.input, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open key file: " << options.input << std::endl;
+            return 1;
+        }
+    } else {
+        std::ios::sync_with_stdio(false);
+    }
+    std::istream& in = file.is_open() ? static_cast<std::istream&>(file) : std::cin;
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::unique_ptr<Sha256Context>> contexts;
+    for (unsigned t = 0; t < threads; t++)
+        contexts.emplace_back(new Sha256Context());
 
-// Check if an 8x8 binary matrix (represented as 8 bytes, one row each) is invertible over GF(2).
-bool isInvertible(uint8_t A[8]) {
-    // Make a copy for Gaussian elimination.
-    uint8_t M[8];
-    memcpy(M, A, 8);
-    // Perform Gaussian elimination mod 2.
-    for (int i = 0; i < 8; i++) {
-        // Find pivot: bit i in row >= i should be 1.
-        bool pivotFound = false;
-        for (int j = i; j < 8; j++) {
-            if ( (M[j] >> i) & 1 ) {
-                // Swap rows i and j if needed.
-                if(j != i) {
-                    uint8_t temp = M[i];
-                    M[i] = M[j];
-                    M[j] = temp;
+    if (options.format == OutputFormat::Header) {
+        std::string head = "/* Keyed S-boxes generated by generateSBox --batch: one entry per key, holding the SHA-256\n"
+                           "   digest of the key and the S-box. */\n"
+                           "#ifndef KEYED_SBOXES_H\n#define KEYED_SBOXES_H\n\n#include <stddef.h>\n#include <stdint.h>\n\n"
+                           "struct keyed_sbox {\n    uint8_t key_digest[32];\n    uint8_t sbox[256];\n};\n\n";
+        fwrite(head.data(), 1, head.size(), stdout);
+    }
+    // The array is opened before its first entry: ISO C has no empty initializers or zero-length arrays
+    const char ARRAY_OPEN[] = "static const struct keyed_sbox KEYED_SBOXES[] = {\n";
+    bool arrayOpen = false;
+
+    uint64_t generated = 0, failed = 0, record = 0;
+    std::vector<std::string> keys;
+    std::vector<uint64_t> records; // Input line (or NUL-delimited record) of every key, for error messages
+    std::vector<std::string> buffers(threads);
+    std::vector<uint64_t> failures(threads);
+    std::string key;
+    while (in) {
+        keys.clear();
+        records.clear();
+        while (keys.size() < CHUNK_KEYS && std::getline(in, key, options.delimiter)) {
+            record++;
+            if (options.delimiter == '\n' && !key.empty() && key.back() == '\r')
+                key.pop_back();
+            if (key.empty()) // Blank lines (including a trailing one) and empty records are not keys
+                continue;
+            keys.push_back(key);
+            records.push_back(record);
+        }
+        if (keys.empty())
+            break;
+
+        size_t share = (keys.size() + threads - 1) / threads;
+        auto worker = [&](unsigned t) {
+            std::string& out = buffers[t];
+            out.clear();
+            failures[t] = 0;
+            unsigned char digest[SHA256_DIGEST_LENGTH];
+            uint8_t sbox[256];
+            size_t end = std::min(keys.size(), (t + 1) * share);
+            for (size_t i = t * share; i < end; i++) {
+                contexts[t]->digest(reinterpret_cast<const uint8_t*>(keys[i].data()), keys[i].size(), digest);
+                if (!generateKeyedSBox(digest, sbox)) {
+                    failures[t]++;
+                    std::string message = (options.delimiter == '\n' ? "Key on line " : "Key in record ") +
+                                          std::to_string(records[i]) +
+                                          ": failed to generate an invertible matrix, skipped.\n";
+                    fputs(message.c_str(), stderr);
+                    continue;
                 }
-                pivotFound = true;
-                break;
+                appendBatchRecord(out, options.format, keys[i], digest, sbox);
             }
-        }
-        if (!pivotFound)
-            return false;
-        // Eliminate the pivot bit from all other rows.
-        for (int j = 0; j < 8; j++) {
-            if (j != i && ((M[j] >> i) & 1)) {
-                M[j] ^= M[i];
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads && t * share < keys.size(); t++)
+            pool.emplace_back(worker, t);
+        worker(0);
+        for (auto& thread : pool)
+            thread.join();
+
+        for (unsigned t = 0; t < threads && t * share < keys.size(); t++) {
+            if (options.format == OutputFormat::Header && !arrayOpen && !buffers[t].empty()) {
+                fputs(ARRAY_OPEN, stdout);
+                arrayOpen = true;
             }
+            fwrite(buffers[t].data(), 1, buffers[t].size(), stdout);
+            failed += failures[t];
         }
+        generated += keys.size();
     }
-    return true;
-}
 
-// Generate an invertible 8x8 matrix (A) and an 8-bit vector (b) from a given key.
-// This function uses SHA-256 to produce candidate bytes. If the candidate matrix is not invertible,
-// we tweak one row.
-void generateKeyDependentAffineParameters(const std::vector<uint8_t>& key, uint8_t A[8], uint8_t &b) {
-    // Compute SHA-256 digest of the key.
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256(key.data(), key.size(), hash);
-    
-    // Use first 8 bytes as candidate rows for A.
-    for (int i = 0; i < 8; i++) {
-        A[i] = hash[i];
-        if (A[i] == 0) A[i] = 1;  // Avoid zero row.
+    if (options.format == OutputFormat::Header) {
+        std::string tail = arrayOpen
+            ? "};\n\nstatic const size_t KEYED_SBOX_COUNT = sizeof(KEYED_SBOXES) / sizeof(KEYED_SBOXES[0]);\n\n"
+            : "static const size_t KEYED_SBOX_COUNT = 0; /* No keys: KEYED_SBOXES is not defined */\n\n";
+        tail += "#endif /* KEYED_SBOXES_H */\n";
+        fwrite(tail.data(), 1, tail.size(), stdout);
     }
-    
-    // If the matrix is not invertible, tweak rows until it is.
-    int attempt = 0;
-    while (!isInvertible(A) && attempt < 256) {
-        // Simple tweak: XOR one row with a constant.
-        A[attempt % 8] ^= 0xFF;
-        attempt++;
+    fflush(stdout);
+    generated -= failed;
+    std::cerr << "Generated " << generated << " S-box(es)";
+    if (failed)
+        std::cerr << ", skipped " << failed << " key(s)";
+    std::cerr << "." << std::endl;
+    return failed ? 1 : 0;
+}
+
+// ------------------- Benchmark and Known-Answer Tests -------------------
+
+// Key used when none is given on the command line.
+const char* const DEFAULT_KEY = "f3747742fb15d353162ebed3ba8d40943b8c222312889630c27261420094f3598c5e77cd9e189cbf66d36b64c847a4555ce16ee9bd650e393e56423f33c49139f5f40a6b3804c49fc9c17dc5cc66be9e3bafdce614072b463a23ec6b0f1654fa35397620865254715b9752514451d06207d523dcb282ef80133192ba491210a9";
+
+// S-box of DEFAULT_KEY as printed by the original implementation (bit-loop field multiplication, brute-force
+// inverse, per-entry affine transform). Every optimized path must keep reproducing it.
+static const uint8_t DEFAULT_KEY_SBOX[256] = {
+    0x7f, 0xc8, 0xa1, 0x0a, 0xae, 0xf6, 0xd4, 0x18, 0x24, 0x1d, 0x5d, 0xb1, 0x05, 0x49, 0xd1, 0xec,
+    0x53, 0x9d, 0xb3, 0x85, 0x27, 0x2f, 0xd5, 0x03, 0x5e, 0xa9, 0x15, 0xf3, 0x67, 0x9a, 0xce, 0x77,
+    0x86, 0xe5, 0x2c, 0x57, 0xab, 0x6f, 0xc1, 0xdc, 0x06, 0xd7, 0x90, 0x4e, 0x2e, 0x02, 0x69, 0xc3,
+    0x72, 0xb5, 0x38, 0x97, 0x25, 0x43, 0x3f, 0xe8, 0x92, 0x01, 0x30, 0x52, 0x96, 0x1a, 0xe9, 0x0c,
+    0x94, 0xd0, 0x73, 0x88, 0xc5, 0x99, 0xcf, 0xb8, 0x46, 0x4d, 0x04, 0xa4, 0x1c, 0x1f, 0x93, 0x12,
+    0x0b, 0xc6, 0x50, 0x19, 0xd8, 0xa8, 0x09, 0x82, 0xbb, 0x1e, 0x42, 0xe0, 0x33, 0xbc, 0x62, 0x3c,
+    0x8b, 0xb4, 0x9c, 0x6a, 0xf7, 0xf1, 0xc4, 0x5f, 0x78, 0xc7, 0xfd, 0x28, 0xeb, 0x8f, 0x87, 0x31,
+    0xa6, 0x58, 0x17, 0x7b, 0x61, 0x2a, 0xad, 0x6c, 0xef, 0xcb, 0xaf, 0x95, 0xac, 0x48, 0xe3, 0x26,
+    0x91, 0xfb, 0x4c, 0x54, 0xa0, 0x0e, 0x35, 0x6e, 0x55, 0x7a, 0x65, 0xc2, 0xbd, 0x0d, 0x68, 0x83,
+    0x9f, 0x7d, 0x5c, 0x20, 0x75, 0xfc, 0xcc, 0xb9, 0x98, 0xf9, 0xcd, 0x8e, 0x8d, 0xed, 0x39, 0xe2,
+    0xff, 0x89, 0x00, 0x74, 0xd3, 0xdf, 0xfa, 0x40, 0xda, 0x6b, 0x13, 0x32, 0x81, 0xa3, 0xdd, 0xa7,
+    0x3d, 0xfe, 0xe6, 0x79, 0xd6, 0xe4, 0x11, 0x7c, 0x34, 0x64, 0x21, 0xdb, 0xf0, 0x47, 0xbe, 0xd9,
+    0x60, 0xea, 0xb7, 0xde, 0x07, 0x37, 0x66, 0xf8, 0x76, 0x6d, 0x41, 0xe7, 0x7e, 0xa2, 0x59, 0x14,
+    0x63, 0x22, 0x2b, 0x10, 0x9e, 0xb0, 0x8c, 0x56, 0xd2, 0x4b, 0x29, 0x80, 0xbf, 0x3a, 0x4a, 0xca,
+    0xb2, 0x8a, 0x45, 0xe1, 0x5b, 0x4f, 0x36, 0xee, 0xa5, 0xaa, 0xf2, 0x3b, 0x71, 0x84, 0x51, 0xc0,
+    0x9b, 0xf5, 0xf4, 0xb6, 0x0f, 0x70, 0xba, 0x16, 0x5a, 0x08, 0x3e, 0x1b, 0x44, 0xc9, 0x2d, 0x23
+};
+
+// Call f repeatedly for at least 200 ms (doubling the batch size) and return the mean nanoseconds per call.
+template <typename F>
+double nanosecondsPerCall(F&& f) {
+    using Clock = std::chrono::steady_clock;
+    uint64_t calls = 0;
+    double elapsed = 0.0;
+    auto start = Clock::now();
+    for (uint64_t batch = 1; elapsed < 2e8; batch *= 2) {
+        for (uint64_t i = 0; i < batch; i++)
+            f();
+        calls += batch;
+        elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
     }
-    if (!isInvertible(A)) {
-        std::cerr << "Failed to generate an invertible matrix from key." << std::endl;
-        exit(1);
+    return elapsed / calls;
+}
+
+// Print one known-answer check and fold it into ok.
+void reportCheck(const char* name, bool passed, bool& ok) {
+    std::cout << "  " << std::left << std::setw(52) << name << std::right << (passed ? "ok" : "FAILED") << std::endl;
+    ok = ok && passed;
+}
+
+// Check the optimized code paths against reference implementations and pinned outputs. Returns false on any mismatch.
+bool runKnownAnswerTests() {
+    bool ok = true;
+    std::cout << "Known-answer tests:" << std::endl;
+
+    bool fieldOk = true;
+    for (int a = 0; a < 256; a++) {
+        for (int c = 0; c < 256; c++)
+            fieldOk = fieldOk && gfMultiply(static_cast<uint8_t>(a), static_cast<uint8_t>(c)) ==
+                                     gfMultiplySlow(static_cast<uint8_t>(a), static_cast<uint8_t>(c));
+        fieldOk = fieldOk && (a == 0 ? GF.inv[0] == 0 : gfMultiplySlow(static_cast<uint8_t>(a), GF.inv[a]) == 1);
     }
-    
-    // Use the 9th byte of the hash as b (if zero, set to a nonzero value).
-    b = hash[8];
-    if (b == 0)
-        b = 0x63; // Fall back to AES constant.
+    reportCheck("GF(2^8) tables match the bit-loop multiply", fieldOk, ok);
+
+    std::vector<uint8_t> key(DEFAULT_KEY, DEFAULT_KEY + strlen(DEFAULT_KEY));
+    uint8_t sbox[256];
+    bool generated = generateKeyedSBox(key, sbox);
+    reportCheck("Default key S-box matches the pinned output", generated && memcmp(sbox, DEFAULT_KEY_SBOX, 256) == 0, ok);
+
+    // Original per-entry path: brute-force-equivalent inverse followed by the row-parity affine transform.
+    uint8_t A[8], b;
+    bool referenceOk = generateKeyDependentAffineParameters(key, A, b);
+    for (int x = 0; x < 256 && referenceOk; x++)
+        referenceOk = affineTransform(multiplicativeInverse(static_cast<uint8_t>(x)), A, b) == sbox[x];
+    reportCheck("Affine table matches the per-entry transform", referenceOk, ok);
+
+    unsigned char digest[SHA256_DIGEST_LENGTH], reused[SHA256_DIGEST_LENGTH];
+    SHA256(key.data(), key.size(), digest);
+    Sha256Context sha256;
+    sha256.digest(key.data(), key.size(), reused);
+    reportCheck("Reused SHA-256 context matches SHA256()", memcmp(digest, reused, sizeof(digest)) == 0, ok);
+
+    KeyedSBoxTables tables;
+    bool tablesOk = buildKeyedSBoxTables(digest, tables) && memcmp(tables.sbox, DEFAULT_KEY_SBOX, 256) == 0;
+    for (int x = 0; x < 256 && tablesOk; x++)
+        tablesOk = tables.inverse[tables.sbox[x]] == x &&
+                   tables.sbox[x] == (tables.affineLow[GF.inv[x] & 15] ^ tables.affineHigh[GF.inv[x] >> 4]) &&
+                   tables.inverse[x] == GF.inv[tables.inverseAffineLow[x & 15] ^ tables.inverseAffineHigh[x >> 4]];
+    reportCheck("Inverse S-box and nibble tables are consistent", tablesOk, ok);
+
+    SBoxAnalyzer analyzer;
+    SBoxAnalysis analysis = analyzer.analyze(DEFAULT_KEY_SBOX);
+    reportCheck("Default key: DU 4, linearity 32, NL 112, degree 7",
+                analysis.differentialUniformity == 4 && analysis.linearity == 32 && analysis.minNonlinearity == 112 &&
+                analysis.maxNonlinearity == 112 && analysis.minAlgebraicDegree == 7 && analysis.maxAlgebraicDegree == 7, ok);
+
+    uint8_t identity[256];
+    for (int x = 0; x < 256; x++)
+        identity[x] = static_cast<uint8_t>(x);
+    analysis = analyzer.analyze(identity);
+    reportCheck("Identity: DU 256, linearity 256, NL 0, degree 1",
+                analysis.differentialUniformity == 256 && analysis.linearity == 256 && analysis.minNonlinearity == 0 &&
+                analysis.minAlgebraicDegree == 1 && analysis.maxAlgebraicDegree == 1, ok);
+
+    // A key whose matrix stays singular through every tweak must be rejected, not looped on.
+    const uint8_t singularKey[] = {1, 2, 3};
+    unsigned char singularDigest[SHA256_DIGEST_LENGTH];
+    SHA256(singularKey, sizeof(singularKey), singularDigest);
+    int tweaks = 0;
+    reportCheck("Singular key is rejected after 16 tweaks",
+                !deriveAffineParameters(singularDigest, A, b, &tweaks) && tweaks == 16, ok);
+
+    ok = checkSBoxKernels(tables) && ok;
+    return ok;
 }
 
-// ------------------- Key-Dependent S-box Generation -------------------
+// Print one timing line.
+void reportTiming(const char* name, double nanoseconds) {
+    std::cout << "  " << std::left << std::setw(52) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << nanoseconds << " ns" << std::defaultfloat << std::endl;
+}
 
-// Generate the keyed S-box. For each input x (0..255):
-// If x is 0, define Inv(x)=0; otherwise, compute the multiplicative inverse in GF(2^8).
-// Then apply the key-dependent affine transformation.
-void generateKeyedSBox(const std::vector<uint8_t>& key, uint8_t sbox[256]) {
-    uint8_t A[8];
-    uint8_t b;
-    generateKeyDependentAffineParameters(key, A, b);
-    
-    for (int x = 0; x < 256; x++) {
-        uint8_t inv = (x == 0) ? 0 : multiplicativeInverse(static_cast<uint8_t>(x));
-        sbox[x] = affineTransform(inv, A, b);
+// Run the known-answer tests, then time every stage of generation and analysis, the bulk kernels and the search
+// loop. Returns the exit status (1 if a known-answer test failed).
+int runBenchmark(const SearchOptions& options) {
+    if (!runKnownAnswerTests())
+        return 1;
+
+    // Digests of distinct keys, cycled through so that per-key work is not measured on a single hot input.
+    const size_t KEYS = 4096;
+    std::vector<std::array<unsigned char, SHA256_DIGEST_LENGTH>> digests(KEYS);
+    std::vector<std::string> keys(KEYS);
+    for (size_t i = 0; i < KEYS; i++) {
+        keys[i] = candidateKey("benchmark", i);
+        SHA256(reinterpret_cast<const uint8_t*>(keys[i].data()), keys[i].size(), digests[i].data());
     }
+    size_t next = 0;
+    volatile uint8_t sink = 0;
+    uint8_t A[8], b;
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    uint8_t sbox[256];
+    Sha256Context sha256;
+    KeyedSBoxTables tables;
+    SBoxAnalyzer analyzer;
+    SBoxAnalysis analysis{};
+
+    std::cout << std::endl << "Per-key setup (ns per key):" << std::endl;
+    reportTiming("SHA-256, one-shot SHA256()", nanosecondsPerCall([&] {
+        const std::string& key = keys[next++ % KEYS];
+        SHA256(reinterpret_cast<const uint8_t*>(key.data()), key.size(), digest);
+        sink = sink + digest[0];
+    }));
+    reportTiming("SHA-256, reused Sha256Context", nanosecondsPerCall([&] {
+        const std::string& key = keys[next++ % KEYS];
+        sha256.digest(reinterpret_cast<const uint8_t*>(key.data()), key.size(), digest);
+        sink = sink + digest[0];
+    }));
+    reportTiming("Matrix derivation incl. retries", nanosecondsPerCall([&] {
+        sink = sink + deriveAffineParameters(digests[next++ % KEYS].data(), A, b);
+    }));
+    reportTiming("S-box generation from digest", nanosecondsPerCall([&] {
+        sink = sink + generateKeyedSBox(digests[next++ % KEYS].data(), sbox);
+    }));
+    reportTiming("All --tables tables from digest", nanosecondsPerCall([&] {
+        sink = sink + buildKeyedSBoxTables(digests[next++ % KEYS].data(), tables);
+    }));
+
+    int tweakCounts[17] = {0};
+    for (size_t i = 0; i < KEYS; i++) {
+        int tweaks = 0;
+        deriveAffineParameters(digests[i].data(), A, b, &tweaks);
+        tweakCounts[tweaks]++;
+    }
+    std::cout << "  Matrix tweaks over " << KEYS << " keys:";
+    for (int t = 0; t <= 16; t++)
+        if (tweakCounts[t])
+            std::cout << " " << t << "x" << tweakCounts[t];
+    std::cout << " (16 = rejected)" << std::endl;
+
+    std::cout << std::endl << "Analysis (ns per S-box):" << std::endl;
+    generateKeyedSBox(digests[0].data(), sbox);
+    reportTiming("DDT and differential uniformity", nanosecondsPerCall([&] {
+        analyzer.analyzeDifferential(sbox, analysis);
+        sink = sink + analysis.differentialUniformity;
+    }));
+    reportTiming("LAT (FWHT) and nonlinearity", nanosecondsPerCall([&] {
+        analyzer.analyzeLinear(sbox, analysis);
+        sink = sink + analysis.minNonlinearity;
+    }));
+    reportTiming("Algebraic degree", nanosecondsPerCall([&] {
+        analyzer.analyzeDegree(sbox, analysis);
+        sink = sink + analysis.minAlgebraicDegree;
+    }));
+    reportTiming("Full analysis and composite score", nanosecondsPerCall([&] {
+        sink = sink + static_cast<uint8_t>(securityScore(analyzer.analyze(sbox)) * 100);
+    }));
+
+    std::cout << std::endl << "Bulk substitution (1 MiB buffer):" << std::endl;
+    static const char* const KERNELS[] = {"scalar", "ssse3", "avx2", "gfni"};
+    buildKeyedSBoxTables(digests[0].data(), tables);
+    std::vector<uint8_t> input(1 << 20), output(input.size());
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+    for (int k = 0; k <= static_cast<int>(bestSBoxKernel()); k++) {
+        double ns = nanosecondsPerCall([&] {
+            substituteBytes(tables, input.data(), output.data(), input.size(), static_cast<SBoxKernel>(k));
+            sink = sink + output[next++ % output.size()];
+        });
+        std::cout << "  " << std::left << std::setw(52) << KERNELS[k] << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(12) << input.size() / ns << " GB/s" << std::defaultfloat << std::endl;
+    }
+
+    SearchOptions search = options;
+    if (!search.candidates)
+        search.candidates = 20000;
+    search.top = 1;
+    std::cout << std::endl << "Search throughput (" << search.candidates << " candidates):" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    searchKeyedSBoxes(DEFAULT_KEY, search);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << std::left << std::setw(52) << "Candidates per second" << std::right << std::fixed
+              << std::setprecision(0) << std::setw(12) << search.candidates / seconds << std::defaultfloat << std::endl;
+    return 0;
 }
 
 // ------------------- Main Function -------------------
 
+// Print an S-box as a C array body, 16 entries per line.
+void printSBox(const uint8_t sbox[256]) {
+    std::string out;
+    appendSBoxText(out, sbox);
+    std::cout << out << std::flush;
+}
+
+// Print a 16-entry table on one line, for the nibble tables of --tables.
+void printNibbleTable(const char* name, const uint8_t table[16]) {
+    std::cout << name << std::hex << std::setfill('0');
+    for (int i = 0; i < 16; i++)
+        std::cout << "0x" << std::setw(2) << static_cast<int>(table[i]) << (i < 15 ? ", " : "\n");
+    std::cout << std::dec << std::setfill(' ');
+}
+
+// Print the inverse S-box, the split-nibble and GFNI forms of the affine layer (see sboxKernel.h), and check the
+// kernels against them. Returns false if a kernel disagrees with the tables.
+bool printSBoxTables(const KeyedSBoxTables& t) {
+    std::cout << std::endl << "Inverse S-box:" << std::endl;
+    printSBox(t.inverse);
+    std::cout << std::endl << "Affine nibble tables, S(x) = low[i & 15] ^ high[i >> 4] with i = inv(x):" << std::endl;
+    printNibbleTable("low:  ", t.affineLow);
+    printNibbleTable("high: ", t.affineHigh);
+    std::cout << std::endl << "Inverse affine nibble tables, S^-1(y) = inv(low[y & 15] ^ high[y >> 4]):" << std::endl;
+    printNibbleTable("low:  ", t.inverseAffineLow);
+    printNibbleTable("high: ", t.inverseAffineHigh);
+    std::cout << std::endl << std::hex << std::setfill('0');
+    std::cout << "GFNI, S(x) = gf2p8affineinvqb(x, matrix, constant):" << std::endl;
+    std::cout << "matrix: 0x" << std::setw(16) << t.gfniMatrix << ", constant: 0x" << std::setw(2)
+              << static_cast<int>(t.gfniConstant) << std::endl;
+    std::cout << "GFNI inverse, S^-1(y) = gf2p8affineinvqb(gf2p8affineqb(y, matrix, constant), 0x"
+              << std::setw(16) << GFNI_IDENTITY << ", 0):" << std::endl;
+    std::cout << "matrix: 0x" << std::setw(16) << t.gfniInverseMatrix << ", constant: 0x" << std::setw(2)
+              << static_cast<int>(t.gfniInverseConstant) << std::endl;
+    std::cout << std::dec << std::setfill(' ') << std::endl;
+    return checkSBoxKernels(t);
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [\"Key\"] [--search N [--top K] [--threads T] [--max-du D] [--min-nl L]]" << std::endl;
+    std::cerr << "       " << program << " [\"Key\"] --tables" << std::endl;
+    std::cerr << "       " << program << " --batch FILE|- [--null] [--format text|binary|header] [--threads T]" << std::endl;
+    std::cerr << "       " << program << " --benchmark [--search N] [--threads T]" << std::endl;
+    std::cerr << "If \"Key\" is not specified, the default one will be used." << std::endl << std::endl;
+    std::cerr << "  --tables      Also print the inverse S-box, nibble and GFNI tables for sboxKernel.h, and self-check it" << std::endl;
+    std::cerr << "  --search N    Derive N candidate keys (\"Key#0\" ... \"Key#N-1\"), score their S-boxes and print the best" << std::endl;
+    std::cerr << "  --top K       Number of best candidates to report (default 10)" << std::endl;
+    std::cerr << "  --threads T   Worker threads (default: one per core)" << std::endl;
+    std::cerr << "  --max-du D    Reject candidates with differential uniformity above D" << std::endl;
+    std::cerr << "  --min-nl L    Reject candidates with nonlinearity below L" << std::endl;
+    std::cerr << "  --batch FILE  Generate one S-box per key read from FILE (\"-\" for stdin), one key per line" << std::endl;
+    std::cerr << "  --null        Keys in the batch input are NUL-delimited instead" << std::endl;
+    std::cerr << "  --benchmark   Run the known-answer tests, then time generation, analysis, kernels and N search" << std::endl;
+    std::cerr << "                candidates (default 20000)" << std::endl;
+    std::cerr << "  --format F    Batch output: text (default), binary (32-byte SHA-256 of the key + 256-byte S-box" << std::endl;
+    std::cerr << "                per key) or header (a C header with a KEYED_SBOXES array)" << std::endl << std::endl;
+    std::cerr << "Algebraically Secure (Key-Dependent) Substitution Box Generator" << std::endl;
+    std::cerr << "Copyright (C) 2025 Aristotle Daskaleas" << std::endl;
+}
+
+// Parse a non-negative decimal option value; exits with the usage text on anything else.
+uint64_t parseCount(const char* program, const char* option, const char* value) {
+    char* end = nullptr;
+    unsigned long long parsed = (value && *value != '-') ? strtoull(value, &end, 10) : 0;
+    if (!value || end == value || *end != '\0') {
+        std::cerr << "Invalid value for " << option << ": " << (value ? value : "(missing)") << std::endl;
+        printUsage(program);
+        exit(1);
+    }
+    return parsed;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc > 1) {
-        if (strcmp(argv[1], "-h") == 0 || strncmp(argv[1], "-help", 5) == 0 || strncmp(argv[1], "--help", 6) == 0) {
-            std::cerr << "Usage: " << argv[0] << " [\"Key\"]" << std::endl;
-            std::cerr << "If \"Key\" is not specified, the default one will be used." << std::endl << std::endl;
-            std::cerr << "Algebraically Secure (Key-Dependent) Substitution Box Generator" << std::endl;
-            std::cerr << "Copyright (C) 2025 Aristotle Daskaleas" << std::endl;
+    const char* keyArg = nullptr;
+    SearchOptions search;
+    BatchOptions batch;
+    bool tables = false;
+    bool benchmark = false;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "-h") == 0 || strncmp(arg, "-help", 5) == 0 || strncmp(arg, "--help", 6) == 0) {
+            printUsage(argv[0]);
+            return 1;
+        } else if (strcmp(arg, "--search") == 0) {
+            search.candidates = parseCount(argv[0], arg, value);
+            i++;
+        } else if (strcmp(arg, "--top") == 0) {
+            search.top = std::max<uint64_t>(1, parseCount(argv[0], arg, value));
+            i++;
+        } else if (strcmp(arg, "--threads") == 0) {
+            search.threads = batch.threads = static_cast<unsigned>(parseCount(argv[0], arg, value));
+            i++;
+        } else if (strcmp(arg, "--batch") == 0) {
+            if (!value) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            batch.input = value;
+            i++;
+        } else if (strcmp(arg, "--tables") == 0) {
+            tables = true;
+        } else if (strcmp(arg, "--benchmark") == 0) {
+            benchmark = true;
+        } else if (strcmp(arg, "--null") == 0) {
+            batch.delimiter = '\0';
+        } else if (strcmp(arg, "--format") == 0) {
+            if (value && strcmp(value, "text") == 0) {
+                batch.format = OutputFormat::Text;
+            } else if (value && strcmp(value, "binary") == 0) {
+                batch.format = OutputFormat::Binary;
+            } else if (value && strcmp(value, "header") == 0) {
+                batch.format = OutputFormat::Header;
+            } else {
+                std::cerr << "Invalid value for --format: " << (value ? value : "(missing)") << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "--max-du") == 0) {
+            search.maxDifferentialUniformity = static_cast<int>(std::min<uint64_t>(256, parseCount(argv[0], arg, value)));
+            i++;
+        } else if (strcmp(arg, "--min-nl") == 0) {
+            search.minNonlinearity = static_cast<int>(std::min<uint64_t>(256, parseCount(argv[0], arg, value)));
+            i++;
+        } else if (!keyArg) {
+            keyArg = arg;
+        } else {
+            printUsage(argv[0]);
             return 1;
         }
     }
     // Get key from command line argument or use a default.
-    std::string keyStr = (argc > 1) ? argv[1] : "f3747742fb15d353162ebed3ba8d40943b8c222312889630c27261420094f3598c5e77cd9e189cbf66d36b64c847a4555ce16ee9bd650e393e56423f33c49139f5f40a6b3804c49fc9c17dc5cc66be9e3bafdce614072b463a23ec6b0f1654fa35397620865254715b9752514451d06207d523dcb282ef80133192ba491210a9";
-    std::vector<uint8_t> key(keyStr.begin(), keyStr.end());
-    
-    uint8_t sbox[256];
-    generateKeyedSBox(key, sbox);
+    std::string keyStr = keyArg ? keyArg : DEFAULT_KEY;
+
+    if (benchmark)
+        return runBenchmark(search);
+
+    if (batch.input) {
+        if (keyArg || search.candidates > 0) {
+            std::cerr << "--batch cannot be combined with a key or --search." << std::endl;
+            return 1;
+        }
+        return runBatch(batch);
+    }
+
+    if (search.candidates > 0) {
+        std::vector<SearchResult> results = searchKeyedSBoxes(keyStr, search);
+        if (results.empty()) {
+            std::cerr << "No candidate met the thresholds." << std::endl;
+            return 1;
+        }
+        std::cout << "Best " << results.size() << " candidate(s):" << std::endl;
+        for (size_t rank = 0; rank < results.size(); rank++) {
+            const SBoxAnalysis& a = results[rank].analysis;
+            std::cout << std::setw(3) << rank + 1 << ". score " << std::fixed << std::setprecision(6)
+                      << results[rank].score << std::defaultfloat << "  DU " << a.differentialUniformity
+                      << "  NL " << a.minNonlinearity << "  degree " << a.minAlgebraicDegree
+                      << "  key \"" << candidateKey(keyStr, results[rank].index) << "\"" << std::endl;
+        }
+        std::string bestKey = candidateKey(keyStr, results.front().index);
+        std::vector<uint8_t> key(bestKey.begin(), bestKey.end());
+        uint8_t sbox[256];
+        generateKeyedSBox(key, sbox);
+        std::cout << std::endl << "Key-dependent S-box:" << std::endl;
+        printSBox(sbox);
+        return 0;
+    }
+
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const uint8_t*>(keyStr.data()), keyStr.size(), digest);
+
+    KeyedSBoxTables keyed;
+    if (!buildKeyedSBoxTables(digest, keyed)) {
+        std::cerr << "Failed to generate an invertible matrix from key." << std::endl;
+        exit(1);
+    }
+    const uint8_t* sbox = keyed.sbox;
 
     // Reached if key was able to generate an inversible S-BOX
 
@@ -522,12 +1313,9 @@ int main(int argc, char* argv[]) {
 
     // Print the generated keyed S-box.
     std::cout << "Key-dependent S-box:" << std::endl;
-    for (int i = 0; i < 256; i++) {
-        std::cout << "0x" << std::hex << std::setw(2) << std::setfill('0')
-                  << static_cast<int>(sbox[i]) << ", ";
-        if ((i + 1) % 16 == 0)
-            std::cout << std::endl;
-    }
-    
+    printSBox(sbox);
+    if (tables && !printSBoxTables(keyed))
+        return 1;
+
     return 0;
 }
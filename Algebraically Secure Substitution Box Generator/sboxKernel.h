@@ -0,0 +1,193 @@
+/*
+  Bulk substitution kernels for keyed S-boxes from generateSBox
+  Copyright (C) 2025  Aristotle Daskaleas
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Header-only reference kernels that apply a keyed S-box S(x) = A * inv(x) ^ b, or its inverse, to a buffer.
+  Fill a KeyedSBoxTables with the values printed by 'generateSBox --tables' and call substituteBytes() or
+  inverseSubstituteBytes(); the fastest kernel the CPU supports is picked at run time (x86 only, scalar elsewhere).
+*/
+
+#ifndef SBOX_KERNEL_H
+#define SBOX_KERNEL_H
+
+#include <cstdint>
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SBOX_KERNEL_X86 1
+#endif
+
+// Tables for one keyed S-box.
+struct KeyedSBoxTables {
+    uint8_t sbox[256];            // S(x); viewed as 16 rows of 16, row h is the pshufb table for high nibble h
+    uint8_t inverse[256];         // S^-1(y), same layout
+    uint8_t affineLow[16];        // A * l ^ b, so that S(x) = affineLow[i & 15] ^ affineHigh[i >> 4] with i = inv(x)
+    uint8_t affineHigh[16];       // A * (h << 4)
+    uint8_t inverseAffineLow[16]; // A^-1 * (l ^ b), so that S^-1(y) = inv(inverseAffineLow[y & 15] ^ inverseAffineHigh[y >> 4])
+    uint8_t inverseAffineHigh[16];// A^-1 * (h << 4)
+    uint64_t gfniMatrix;          // A in GF2P8AFFINE layout (byte 7 - i holds row i): S(x) = gf2p8affineinvqb(x, gfniMatrix, gfniConstant)
+    uint8_t gfniConstant;         // b
+    uint64_t gfniInverseMatrix;   // A^-1 in the same layout: S^-1(y) = inv(gf2p8affineqb(y, gfniInverseMatrix, gfniInverseConstant))
+    uint8_t gfniInverseConstant;  // A^-1 * b
+};
+
+enum class SBoxKernel { Scalar, SSSE3, AVX2, GFNI };
+
+// The identity matrix in GF2P8AFFINE layout, used to get a bare field inversion out of gf2p8affineinvqb.
+const uint64_t GFNI_IDENTITY = 0x0102040810204080ULL;
+
+// Best kernel for the running CPU.
+inline SBoxKernel bestSBoxKernel() {
+#ifdef SBOX_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx2"))
+        return SBoxKernel::GFNI;
+    if (__builtin_cpu_supports("avx2"))
+        return SBoxKernel::AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+        return SBoxKernel::SSSE3;
+#endif
+    return SBoxKernel::Scalar;
+}
+
+// Plain table lookup; also finishes the tails of the vector kernels.
+inline void substituteScalar(const uint8_t table[256], const uint8_t* in, uint8_t* out, size_t size) {
+    for (size_t i = 0; i < size; i++)
+        out[i] = table[in[i]];
+}
+
+#ifdef SBOX_KERNEL_X86
+// 16-row pshufb scan: for every high nibble h, x - 16h (wrapping) is below 16 exactly in the lanes whose high nibble
+// is h, and a saturating add of 0x70 sets bit 7 (which makes pshufb return 0) in all other lanes. OR-ing the 16 row
+// lookups yields the full 256-entry lookup. This is about 4 instructions per row, so it only matches scalar lookups
+// with 16-byte vectors; it pays off with 32-byte vectors and is mainly the fallback for CPUs without GFNI.
+__attribute__((target("ssse3")))
+inline void substituteSSSE3(const uint8_t table[256], const uint8_t* in, uint8_t* out, size_t size) {
+    const __m128i bias = _mm_set1_epi8(0x70);
+    const __m128i step = _mm_set1_epi8(0x10);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) { // Two vectors per step share each row load
+        __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 16));
+        __m128i r0 = _mm_setzero_si128();
+        __m128i r1 = _mm_setzero_si128();
+        for (int h = 0; h < 16; h++) { // x - 16h is below 16 exactly in the lanes of row h
+            __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * h));
+            r0 = _mm_or_si128(r0, _mm_shuffle_epi8(row, _mm_adds_epu8(x0, bias)));
+            r1 = _mm_or_si128(r1, _mm_shuffle_epi8(row, _mm_adds_epu8(x1, bias)));
+            x0 = _mm_sub_epi8(x0, step);
+            x1 = _mm_sub_epi8(x1, step);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 16), r1);
+    }
+    substituteScalar(table, in + i, out + i, size - i);
+}
+
+// The SSSE3 scheme on 32 bytes per step, with each row broadcast to both 128-bit lanes.
+__attribute__((target("avx2")))
+inline void substituteAVX2(const uint8_t table[256], const uint8_t* in, uint8_t* out, size_t size) {
+    const __m256i bias = _mm256_set1_epi8(0x70);
+    const __m256i step = _mm256_set1_epi8(0x10);
+    __m256i rows[16];
+    for (int h = 0; h < 16; h++)
+        rows[h] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * h)));
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i result = _mm256_setzero_si256();
+        for (int h = 0; h < 16; h++) {
+            result = _mm256_or_si256(result, _mm256_shuffle_epi8(rows[h], _mm256_adds_epu8(x, bias)));
+            x = _mm256_sub_epi8(x, step);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+    }
+    substituteScalar(table, in + i, out + i, size - i);
+}
+
+// One gf2p8affineinvqb per 32 bytes. The instruction's constant is an immediate, so the key-dependent b is XORed in
+// separately.
+__attribute__((target("gfni,avx2")))
+inline void substituteGFNI(const KeyedSBoxTables& t, const uint8_t* in, uint8_t* out, size_t size) {
+    const __m256i matrix = _mm256_set1_epi64x(static_cast<long long>(t.gfniMatrix));
+    const __m256i constant = _mm256_set1_epi8(static_cast<char>(t.gfniConstant));
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i y = _mm256_xor_si256(_mm256_gf2p8affineinv_epi64_epi8(x, matrix, 0), constant);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), y);
+    }
+    substituteScalar(t.sbox, in + i, out + i, size - i);
+}
+
+// Inverse with two GFNI instructions: undo the affine map (gf2p8affineqb with A^-1), then invert in the field.
+__attribute__((target("gfni,avx2")))
+inline void inverseSubstituteGFNI(const KeyedSBoxTables& t, const uint8_t* in, uint8_t* out, size_t size) {
+    const __m256i matrix = _mm256_set1_epi64x(static_cast<long long>(t.gfniInverseMatrix));
+    const __m256i constant = _mm256_set1_epi8(static_cast<char>(t.gfniInverseConstant));
+    const __m256i identity = _mm256_set1_epi64x(static_cast<long long>(GFNI_IDENTITY));
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i z = _mm256_xor_si256(_mm256_gf2p8affine_epi64_epi8(y, matrix, 0), constant);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_gf2p8affineinv_epi64_epi8(z, identity, 0));
+    }
+    substituteScalar(t.inverse, in + i, out + i, size - i);
+}
+#endif
+
+// out[i] = S(in[i]) for size bytes; in and out may be the same buffer.
+inline void substituteBytes(const KeyedSBoxTables& t, const uint8_t* in, uint8_t* out, size_t size,
+                            SBoxKernel kernel = bestSBoxKernel()) {
+    switch (kernel) {
+#ifdef SBOX_KERNEL_X86
+    case SBoxKernel::GFNI:
+        substituteGFNI(t, in, out, size);
+        return;
+    case SBoxKernel::AVX2:
+        substituteAVX2(t.sbox, in, out, size);
+        return;
+    case SBoxKernel::SSSE3:
+        substituteSSSE3(t.sbox, in, out, size);
+        return;
+#endif
+    default:
+        substituteScalar(t.sbox, in, out, size);
+    }
+}
+
+// out[i] = S^-1(in[i]) for size bytes; in and out may be the same buffer.
+inline void inverseSubstituteBytes(const KeyedSBoxTables& t, const uint8_t* in, uint8_t* out, size_t size,
+                                   SBoxKernel kernel = bestSBoxKernel()) {
+    switch (kernel) {
+#ifdef SBOX_KERNEL_X86
+    case SBoxKernel::GFNI:
+        inverseSubstituteGFNI(t, in, out, size);
+        return;
+    case SBoxKernel::AVX2:
+        substituteAVX2(t.inverse, in, out, size);
+        return;
+    case SBoxKernel::SSSE3:
+        substituteSSSE3(t.inverse, in, out, size);
+        return;
+#endif
+    default:
+        substituteScalar(t.inverse, in, out, size);
+    }
+}
+
+#endif
@@ -0,0 +1,215 @@
+/*
+  Persisted directory index for incremental runs of the file mode scripts.
+  Copyright (C) 2024  Aristotle Daskaleas
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+// Records, for every directory a run finished without errors, its device+inode, mtime, ctime and mode along with
+// the names of its subdirectories. On the next run with the same spec, a directory whose record still matches is not
+// read and none of its files are stat()ed; only its recorded subdirectories are visited. The index file is
+// memory-mapped and searched in place, so loading it costs nothing proportional to its size.
+//
+// Creating, removing or renaming an entry updates the directory's mtime, but chmod() on a file inside it does not:
+// permission changes made to existing files by other means are only picked up by a run with --full.
+//
+// File layout (native endianness, written by and for the same machine):
+//   modeIndexHeader, then recordCount modeIndexRecord sorted by (device, inode), then the name pool of
+//   NUL-terminated subdirectory names that records point into.
+
+#ifndef MODE_INDEX_H
+#define MODE_INDEX_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+const char MODE_INDEX_MAGIC[8] = {'F', 'M', 'I', 'D', 'X', '1', '\0', '\0'};
+
+struct modeIndexHeader {
+    char magic[8];
+    uint64_t specHash; // Spec, euid and egid the index was built for; any change invalidates it
+    uint64_t recordCount;
+    uint64_t namePoolSize;
+};
+
+struct modeIndexRecord {
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtimeSec, mtimeNsec;
+    int64_t ctimeSec, ctimeNsec;
+    uint32_t mode;
+    uint32_t childCount; // Number of subdirectory names
+    uint64_t childOffset; // Offset of the first name in the name pool
+};
+
+// FNV-1a over the spec text and the runner's credentials.
+inline uint64_t modeIndexHash(const std::string &spec, uid_t euid, gid_t egid) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&](const void *data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<const unsigned char *>(data)[i]) * 0x100000001b3ULL;
+        }
+    };
+    mix(spec.data(), spec.size());
+    mix(&euid, sizeof euid);
+    mix(&egid, sizeof egid);
+    return hash;
+}
+
+// Whether a directory's current stat still matches its record.
+inline bool modeIndexMatches(const modeIndexRecord &record, const struct stat &dirStat) {
+    return record.mtimeSec == dirStat.st_mtim.tv_sec && record.mtimeNsec == dirStat.st_mtim.tv_nsec
+        && record.ctimeSec == dirStat.st_ctim.tv_sec && record.ctimeNsec == dirStat.st_ctim.tv_nsec
+        && record.mode == static_cast<uint32_t>(dirStat.st_mode);
+}
+
+class modeIndex {
+public:
+    modeIndex() = default;
+    modeIndex(const modeIndex &) = delete;
+    modeIndex &operator=(const modeIndex &) = delete;
+    ~modeIndex() { unload(); }
+
+    // Map an existing index. A missing, truncated or foreign file (or one built for another spec) simply leaves the
+    // index empty, which makes the run a full scan.
+    void load(const std::string &path, uint64_t specHash) {
+        unload();
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) { return; }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && static_cast<size_t>(fileStat.st_size) >= sizeof(modeIndexHeader)) {
+            void *mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED) {
+                mapped = static_cast<const unsigned char *>(mapping);
+                mappedSize = fileStat.st_size;
+            }
+        }
+        close(fd);
+        if (mapped == nullptr) { return; }
+
+        const auto *header = reinterpret_cast<const modeIndexHeader *>(mapped);
+        uint64_t recordBytes = header->recordCount * sizeof(modeIndexRecord);
+        if (std::memcmp(header->magic, MODE_INDEX_MAGIC, sizeof MODE_INDEX_MAGIC) != 0 || header->specHash != specHash
+            || header->recordCount > mappedSize / sizeof(modeIndexRecord)
+            || sizeof(modeIndexHeader) + recordBytes + header->namePoolSize != mappedSize) {
+            unload();
+            return;
+        }
+        records = reinterpret_cast<const modeIndexRecord *>(mapped + sizeof(modeIndexHeader));
+        recordCount = header->recordCount;
+        namePool = reinterpret_cast<const char *>(records + recordCount);
+        namePoolSize = header->namePoolSize;
+    }
+
+    // Record of a directory from the loaded index, or nullptr.
+    const modeIndexRecord *find(const struct stat &dirStat) const {
+        auto key = std::make_pair(static_cast<uint64_t>(dirStat.st_dev), static_cast<uint64_t>(dirStat.st_ino));
+        const modeIndexRecord *end = records + recordCount;
+        const modeIndexRecord *it = std::lower_bound(records, end, key, [](const modeIndexRecord &r, const auto &k) {
+            return std::make_pair(r.device, r.inode) < k;
+        });
+        return it != end && it->device == key.first && it->inode == key.second ? it : nullptr;
+    }
+
+    // Subdirectory names of a loaded record, or an empty list if the record points outside the name pool.
+    std::vector<std::string> children(const modeIndexRecord &record) const {
+        std::vector<std::string> names;
+        uint64_t offset = record.childOffset;
+        for (uint32_t i = 0; i < record.childCount; ++i) {
+            const void *terminator = offset < namePoolSize
+                ? std::memchr(namePool + offset, '\0', namePoolSize - offset) : nullptr;
+            if (terminator == nullptr) { return {}; }
+            names.emplace_back(namePool + offset);
+            offset = static_cast<const char *>(terminator) - namePool + 1;
+        }
+        return names;
+    }
+
+    // Queue a directory for the next index; safe to call from the worker threads.
+    void record(const struct stat &dirStat, const std::vector<std::string> &subdirectoryNames) {
+        modeIndexRecord entry{static_cast<uint64_t>(dirStat.st_dev), static_cast<uint64_t>(dirStat.st_ino),
+                              dirStat.st_mtim.tv_sec, dirStat.st_mtim.tv_nsec,
+                              dirStat.st_ctim.tv_sec, dirStat.st_ctim.tv_nsec,
+                              static_cast<uint32_t>(dirStat.st_mode),
+                              static_cast<uint32_t>(subdirectoryNames.size()), 0};
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        entry.childOffset = pendingNames.size();
+        for (const auto &name : subdirectoryNames) { pendingNames.append(name.c_str(), name.size() + 1); }
+        pendingRecords.push_back(entry);
+    }
+
+    // Write the recorded directories to path (via a temporary file and rename(), so a crash keeps the old index).
+    bool save(const std::string &path, uint64_t specHash) {
+        std::sort(pendingRecords.begin(), pendingRecords.end(), [](const modeIndexRecord &a, const modeIndexRecord &b) {
+            return std::make_pair(a.device, a.inode) < std::make_pair(b.device, b.inode);
+        });
+        // The same directory reached through two command-line paths is kept once
+        pendingRecords.erase(std::unique(pendingRecords.begin(), pendingRecords.end(),
+                                         [](const modeIndexRecord &a, const modeIndexRecord &b) {
+                                             return a.device == b.device && a.inode == b.inode;
+                                         }), pendingRecords.end());
+
+        modeIndexHeader header{};
+        std::memcpy(header.magic, MODE_INDEX_MAGIC, sizeof MODE_INDEX_MAGIC);
+        header.specHash = specHash;
+        header.recordCount = pendingRecords.size();
+        header.namePoolSize = pendingNames.size();
+
+        std::string temporary = path + ".tmp";
+        FILE *file = std::fopen(temporary.c_str(), "wb");
+        if (file == nullptr) { return false; }
+        bool written = std::fwrite(&header, sizeof header, 1, file) == 1
+            && std::fwrite(pendingRecords.data(), sizeof(modeIndexRecord), pendingRecords.size(), file)
+                   == pendingRecords.size()
+            && std::fwrite(pendingNames.data(), 1, pendingNames.size(), file) == pendingNames.size();
+        written = std::fclose(file) == 0 && written;
+        if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void unload() {
+        if (mapped != nullptr) { munmap(const_cast<unsigned char *>(mapped), mappedSize); }
+        mapped = nullptr;
+        mappedSize = 0;
+        records = nullptr;
+        recordCount = 0;
+        namePool = nullptr;
+        namePoolSize = 0;
+    }
+
+    const unsigned char *mapped = nullptr;
+    size_t mappedSize = 0;
+    const modeIndexRecord *records = nullptr;
+    uint64_t recordCount = 0;
+    const char *namePool = nullptr;
+    uint64_t namePoolSize = 0;
+
+    std::mutex pendingMutex;
+    std::vector<modeIndexRecord> pendingRecords;
+    std::string pendingNames;
+};
+
+#endif
@@ -0,0 +1,34 @@
+/*
+  File permission modifier. Will apply a combined symbolic mode (e.g. u+rw,g-x) to all specified files in one pass.
+  Copyright (C) 2024  Aristotle Daskaleas
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+// This program is designed to recursively apply any combination of permission changes for specified files
+
+#include "permissionEngine.h"
+
+int main(int argc, char *argv[]) {
+    return runPermissionTool(argc, argv,
+        "[-v|--verbose] [-j|--jobs N] [--index FILE [--full]] [--stats] <spec> <file1> [directory2]...\n"
+        "This program applies every clause of a symbolic spec (e.g. u+rw,g-x,o=r) to each file in a single pass.\n"
+        "Classes are u, g, o, a, c (the runner's own class for each file) and C (that class and all after it).\n"
+        "Directories are immediately and recursively processed.",
+        [](std::vector<fs::path> &arguments) {
+            if (arguments.empty()) { return std::string(); }
+            std::string spec = arguments.front().string();
+            arguments.erase(arguments.begin());
+            return spec;
+        });
+}
@@ -0,0 +1,354 @@
+/*
+  Shared permission engine for the file mode scripts (mp, fp, rp, wp, xp, np).
+  Copyright (C) 2024  Aristotle Daskaleas
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+// Parses a combined symbolic permission spec (e.g. "u+rw,g-x,c+r") once and applies every clause to each file in a
+// single pass, walking directory trees with the shared worker-pool walker from fsCore.h. Each tool only supplies its
+// extra flags and the spec it wants applied.
+
+#ifndef PERMISSION_ENGINE_H
+#define PERMISSION_ENGINE_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <sys/stat.h>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include "../Filesystem Core/fsCore.h"
+#include "modeIndex.h"
+
+namespace fs = std::filesystem; // Opens a namespace for easy access
+
+bool verbose = false; // Flag to specify verbosity (essentially every output message)
+unsigned jobs = 0; // Number of worker threads used to walk directories (0 = one per core)
+std::string indexPath; // Directory index for incremental runs (none if empty)
+bool fullScan = false; // Ignore the index's records (it is still rewritten)
+bool printStats = false; // Print the walker's counters when done
+modeIndex directoryIndex; // Loaded index plus the records gathered by this run
+
+// Who a clause applies to. Besides the fixed u/g/o classes, the tools historically acted on the class the script
+// runner falls into for each file (owner, else group, else other): 'c' selects that class, and 'C' selects it and
+// every class after it (owner -> ugo, group -> go, other -> o).
+enum permissionWho : unsigned { whoUser = classOwner, whoGroup = classGroup, whoOther = classOther, whoCaller = 8,
+                                whoCallerAndBelow = 16 };
+
+struct permissionClause {
+    unsigned who; // permissionWho bits
+    char op; // '+', '-' or '='
+    mode_t perms; // Permission bits in the 'other' position (r = 4, w = 2, x = 1)
+};
+
+// Parse a comma-separated symbolic spec: [ugoacC]*[+-=][rwx]*, e.g. "u+rw,g-x,o=r". An empty who means 'a'.
+std::vector<permissionClause> parsePermissionSpec(const std::string &spec) {
+    std::vector<permissionClause> clauses;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) { end = spec.size(); }
+        std::string part = spec.substr(start, end - start);
+        permissionClause clause{0, 0, 0};
+        size_t i = 0;
+        for (; i < part.size() && std::strchr("ugoacC", part[i]); ++i) {
+            switch (part[i]) {
+                case 'u': clause.who |= whoUser; break;
+                case 'g': clause.who |= whoGroup; break;
+                case 'o': clause.who |= whoOther; break;
+                case 'a': clause.who |= whoUser | whoGroup | whoOther; break;
+                case 'c': clause.who |= whoCaller; break;
+                case 'C': clause.who |= whoCallerAndBelow; break;
+            }
+        }
+        if (i == part.size() || !std::strchr("+-=", part[i])) {
+            throw std::invalid_argument("Invalid permission spec: '" + part + "' (expected e.g. u+rw,g-x)");
+        }
+        if (clause.who == 0) { clause.who = whoUser | whoGroup | whoOther; }
+        clause.op = part[i++];
+        for (; i < part.size(); ++i) {
+            switch (part[i]) {
+                case 'r': clause.perms |= 4; break;
+                case 'w': clause.perms |= 2; break;
+                case 'x': clause.perms |= 1; break;
+                default: throw std::invalid_argument("Invalid permission in spec '" + part + "': " + part[i]);
+            }
+        }
+        clauses.push_back(clause);
+        start = end + 1;
+    }
+    return clauses;
+}
+
+// Resolve a clause's who bits to concrete u/g/o classes for a file, given the runner's class for it (whoUser,
+// whoGroup or whoOther).
+unsigned resolveWho(unsigned who, unsigned callerClass) {
+    unsigned classes = who & (whoUser | whoGroup | whoOther);
+    if (who & whoCaller) { classes |= callerClass; }
+    if (who & whoCallerAndBelow) {
+        classes |= callerClass == whoUser ? whoUser | whoGroup | whoOther
+                 : callerClass == whoGroup ? whoGroup | whoOther : whoOther;
+    }
+    return classes;
+}
+
+// Permission bits of the given classes, with perms placed in each class' position.
+mode_t classBits(unsigned classes, mode_t perms) {
+    return ((classes & whoUser) ? perms << 6 : 0) | ((classes & whoGroup) ? perms << 3 : 0)
+         | ((classes & whoOther) ? perms : 0);
+}
+
+// Symbolic form of the clauses as resolved for one file (e.g. "u+r,go-w"), for verbose output.
+std::string describeClauses(const std::vector<permissionClause> &clauses, unsigned callerClass) {
+    std::string description;
+    for (const auto &clause : clauses) {
+        unsigned classes = resolveWho(clause.who, callerClass);
+        if (!description.empty()) { description += ','; }
+        if (classes & whoUser) { description += 'u'; }
+        if (classes & whoGroup) { description += 'g'; }
+        if (classes & whoOther) { description += 'o'; }
+        description += clause.op;
+        if (clause.perms & 4) { description += 'r'; }
+        if (clause.perms & 2) { description += 'w'; }
+        if (clause.perms & 1) { description += 'x'; }
+    }
+    return description;
+}
+
+// Serializes output lines from the worker threads.
+std::mutex outputMutex;
+
+void report(std::ostream &stream, const std::string &line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    stream << line << std::endl;
+}
+
+// Counters for --stats, shared by the walker and modifyPermissions()
+walkCounters counters;
+
+// Apply every clause to one file whose stat the caller already has, issuing fchmodat() only if the mode changes.
+// name is resolved relative to dirFd (AT_FDCWD for command-line paths); displayPath is only used for messages.
+// Returns false if the file was refused or could not be changed.
+bool modifyPermissions(int dirFd, const char *name, const std::string &displayPath, const struct stat &fileStat,
+                       const std::vector<permissionClause> &clauses) {
+    const callerCredentials &caller = callerCredentials::current();
+
+    // Ensure script is not run as root unless root owns the files
+    if ((caller.euid == 0 && fileStat.st_uid != 0) || (caller.egid == 0 && fileStat.st_gid != 0)) {
+        report(std::cerr, "\tCannot modify file '" + displayPath + "' as root unless root owns it.");
+        return false;
+    }
+
+    // Determine the runner's class for this file
+    unsigned callerClass = classOf(fileStat.st_uid, fileStat.st_gid, caller.euid, caller.egid);
+
+    mode_t newPermissions = fileStat.st_mode & 07777;
+    for (const auto &clause : clauses) {
+        unsigned classes = resolveWho(clause.who, callerClass);
+        mode_t bits = classBits(classes, clause.perms);
+        switch (clause.op) {
+            case '+': newPermissions |= bits; break;
+            case '-': newPermissions &= ~bits; break;
+            case '=': newPermissions = (newPermissions & ~classBits(classes, 7)) | bits; break;
+        }
+    }
+
+    // Every clause at once; walked entries are never changed through a symlink (command-line paths are followed)
+    int changed = changeMode(dirFd, name, fileStat.st_mode, newPermissions, &counters, dirFd != AT_FDCWD);
+    if (changed == 0) {
+        if (verbose) { report(std::cerr, "\tFile '" + displayPath + "' already has the requested permissions."); }
+    } else if (changed < 0) {
+        report(std::cerr, "\tFailed to update permissions for '" + displayPath + "': " + std::strerror(errno));
+        return false;
+    } else if (verbose) {
+        report(std::cout, "\tUpdated permissions for file '" + displayPath + "' ("
+               + describeClauses(clauses, callerClass) + ")");
+    }
+    return true;
+}
+
+// Walk a directory tree with the shared walker (see fsCore.h), applying the clauses to every regular file. With an
+// index, a directory whose record still matches is not read: only its recorded subdirectories are visited.
+// Directories handled without errors are recorded for the next run. Symlinks inside the tree (to files or
+// directories) are not followed.
+void processDirectoryTree(const std::string &root, const std::vector<permissionClause> &clauses) {
+    walkOptions options;
+    options.jobs = jobs;
+    options.counters = &counters;
+
+    walkVisitor visitor;
+    visitor.file = [&](int dirFd, const char *name, const std::string &path, const struct stat &fileStat, bool) {
+        return modifyPermissions(dirFd, name, path, fileStat, clauses);
+    };
+    visitor.error = [](const std::string &message) { report(std::cerr, "\t" + message); };
+    if (!indexPath.empty()) {
+        visitor.reuse = [](const std::string &path, const struct stat &dirStat, std::vector<std::string> &subdirectories) {
+            const modeIndexRecord *known = fullScan ? nullptr : directoryIndex.find(dirStat);
+            if (known == nullptr || !modeIndexMatches(*known, dirStat)) { return false; }
+            if (verbose) { report(std::cout, "\tSkipping unchanged directory '" + path + "'"); }
+            subdirectories = directoryIndex.children(*known);
+            directoryIndex.record(dirStat, subdirectories);
+            return true;
+        };
+        visitor.finished = [](const std::string &, const struct stat &dirStat,
+                              const std::vector<std::string> &subdirectories, bool clean) {
+            if (clean) { directoryIndex.record(dirStat, subdirectories); }
+        };
+    }
+    walkTree(root, options, visitor);
+}
+
+// Flags shared by every tool; tools add their own to flagActions before calling parseArguments().
+std::unordered_map<std::string, std::function<void()>> flagActions = {
+    {"v", []() { verbose = true; }},
+    {"verbose", []() { verbose = true; }},
+    {"full", []() { fullScan = true; }},
+    {"stats", []() { printStats = true; }}
+};
+
+// Parse a worker count for -j/--jobs.
+void parseJobs(const std::string &value) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || value.size() > 4) {
+        throw std::invalid_argument("Invalid job count: " + value);
+    }
+    jobs = static_cast<unsigned>(std::stoul(value));
+}
+
+// Flags that take a value ("-j 4", "--jobs 4" or "--jobs=4").
+std::unordered_map<std::string, std::function<void(const std::string &)>> valueFlagActions = {
+    {"j", parseJobs},
+    {"jobs", parseJobs},
+    {"index", [](const std::string &value) { indexPath = value; }}
+};
+
+std::vector<fs::path> parseArguments(int argc, char *argv[]) {
+    std::vector<fs::path> filePaths;
+
+    for (int i = 1; i < argc; ++i) { // Iterates through arguments
+        std::string arg = argv[i]; // Sets the current argument to a string
+
+        if (arg[0] == '-' && arg[1] != '-') {
+            if (arg.substr(1).length() == 0) { throw std::invalid_argument("A flag must be specified. (-)"); }
+            for (size_t j = 1; j < arg.length(); ++j) {
+                std::string shortFlag(1, arg[j]);
+                if (flagActions.find(shortFlag) != flagActions.end()) {
+                    flagActions[shortFlag]();
+                } else if (valueFlagActions.find(shortFlag) != valueFlagActions.end()) {
+                    std::string value = arg.substr(j + 1); // "-j4" or "-j 4"
+                    if (value.empty()) {
+                        if (++i >= argc) { throw std::invalid_argument("Flag -" + shortFlag + " requires a value."); }
+                        value = argv[i];
+                    }
+                    valueFlagActions[shortFlag](value);
+                    break;
+                } else {
+                    throw std::invalid_argument("Invalid flag: -" + shortFlag);
+                }
+            }
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            std::string longOption = arg.substr(2);
+            if (longOption.length() == 0) { throw std::invalid_argument("A flag must be specified. (--)"); }
+            size_t equals = longOption.find('=');
+            std::string name = longOption.substr(0, equals);
+            if (equals == std::string::npos && flagActions.find(name) != flagActions.end()) {
+                flagActions[name]();
+            } else if (valueFlagActions.find(name) != valueFlagActions.end()) {
+                std::string value;
+                if (equals != std::string::npos) {
+                    value = longOption.substr(equals + 1);
+                } else if (++i < argc) {
+                    value = argv[i];
+                } else {
+                    throw std::invalid_argument("Flag --" + name + " requires a value.");
+                }
+                valueFlagActions[name](value);
+            } else {
+                throw std::invalid_argument("Invalid flag: --" + longOption);
+            }
+        } else {
+            filePaths.emplace_back(argv[i]);
+        }
+    }
+    return filePaths;
+}
+
+// Apply the clauses to every given path: files directly, directories recursively through the worker pool. Each path
+// is stat()ed once, following symlinks as the tools always have for command-line arguments. With --index the index
+// is loaded first (unless --full) and rewritten afterwards from the directories this run visited.
+void processPaths(const std::vector<fs::path> &filePaths, const std::string &spec,
+                  const std::vector<permissionClause> &clauses) {
+    const callerCredentials &caller = callerCredentials::current();
+    uint64_t specHash = modeIndexHash(spec, caller.euid, caller.egid);
+    if (!indexPath.empty() && !fullScan) { directoryIndex.load(indexPath, specHash); }
+
+    for (const auto &filePath : filePaths) {
+        struct stat fileStat;
+        if (stat(filePath.c_str(), &fileStat) == -1) {
+            std::cerr << "Error: File or directory '" << filePath.string()
+                      << "' does not exist." << std::endl;
+            continue;
+        }
+
+        if (S_ISDIR(fileStat.st_mode)) {
+            if (verbose) { std::cout << "Processing directory: " << filePath.string() << std::endl; }
+            processDirectoryTree(filePath.string(), clauses);
+        } else if (S_ISREG(fileStat.st_mode)) {
+            if (verbose) { std::cout << "Processing file: " << filePath.string() << std::endl; }
+            modifyPermissions(AT_FDCWD, filePath.c_str(), filePath.string(), fileStat, clauses);
+        } else {
+            if (verbose) { std::cerr << "Skipping unsupported file: " << filePath.string() << std::endl; }
+        }
+    }
+
+    if (!indexPath.empty() && !directoryIndex.save(indexPath, specHash)) {
+        std::cerr << "Error: Failed to write index '" << indexPath << "': " << std::strerror(errno) << std::endl;
+    }
+    if (printStats) { std::cerr << "Stats: " << counters.summary() << std::endl; }
+}
+
+// Common main() body: parse the arguments, let the tool turn its flags and leading arguments into a spec, and apply
+// it. makeSpec receives the non-flag arguments and removes any it consumes (mp takes the spec from the first one).
+int runPermissionTool(int argc, char *argv[], const std::string &usage,
+                      const std::function<std::string(std::vector<fs::path> &)> &makeSpec) {
+    try {
+        std::vector<fs::path> filePaths = parseArguments(argc, argv); // Initializes vector to store file paths
+        std::string spec = makeSpec(filePaths);
+
+        if (filePaths.empty()) {
+            std::cerr << "Usage: " << argv[0] << " " << usage << std::endl;
+#ifndef _WIN32
+            return EXIT_FAILURE + 1;
+#else
+            return EXIT_FAILURE;
+#endif
+        }
+        processPaths(filePaths, spec, parsePermissionSpec(spec));
+    } catch (const std::invalid_argument &ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (const std::exception &ex) {
+        std::cerr << "An error occurred: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#endif
@@ -17,7 +17,7 @@
 */
 /*
 File and Directory Shredder
-Version: 10.7d
+Version: 10.9o
 Author: Aristotle Daskaleas (2025)
 Changelog (since v10):
     -> As of version 10, format of version is now XX.Xx where X ~ [0-9] and x ~ [a-z]
@@ -58,12 +58,60 @@ Changelog (since v10):
     -> Updated copyright year
     -> Fixed potential undefined behavior exposed with -Wall flag
     -> Fixed metadata function for true linux support
+10.8-> Replaced secureRandom, randomizer and secureRandomizer with a single entropySource (getrandom(2) / held /dev/urandom descriptor / BCrypt, with RAND_bytes or Mersenne Twister fallback)
+    -> Random data is now filled in place into a reusable buffer (no per-block open/read/close or allocations)
+    -> Added a keystream class (ChaCha20 / AES-256-CTR) seeded once per pass from the entropy source, selectable with --rng=kernel|chacha|aesctr
+    -> OpenSSL builds generate the keystream through EVP (AES-NI / SIMD ChaCha20); other builds use a portable ChaCha20
+    -> Verification now streams in constant memory: removed the whole-file lastRandomData copy and the whole-file read in verifyWithHash()
+    -> Keystream passes are verified by regenerating the final pass from its seed; kernel passes by an incremental digest (streamDigest)
+    -> getOptimalBlockSize() now sizes transfers per file (st_blksize, device optimal I/O size, RAID stripe width) with ~4 MiB page-aligned buffers
+    -> Fixed macOS block size (was kern.maxfiles); added --block-size override and reported the chosen geometry under --internal
+    -> Secure mode now writes each pattern as its own sequential sweep over the file with a flush/fsync barrier in between (was ~15 seeks per block)
+10.9-> Replaced std::fstream with a raw file handle (rawFile) using direct I/O: O_DIRECT (Linux), F_NOCACHE (macOS), FILE_FLAG_NO_BUFFERING|WRITE_THROUGH (Windows)
+    -> Unaligned transfers and file systems without direct I/O fall back to buffered I/O; added --buffered to always use buffered I/O
+    -> Every sweep is now synchronized through the open handle (F_FULLFSYNC on macOS); removed syncFile(), which reopened the file just to fsync
+    -> Brought back multithreading as a bounded worker pool (-j|--jobs); each file is owned by one worker, so per-file state (wPerm, internal) is thread_local
+    -> Program error status is atomic, log lines are serialized, and fileMutex now only guards the rename into the temp directory
+    -> Added a per-device concurrency limit (--device-jobs); spinning disks default to one file at a time
+    -> Large files are split into block-aligned ranges overwritten in parallel (--file-threads), each with its own keystream and buffers
+    -> Verification runs per range too; hashed (kernel) passes compare a digest combined from the per-range digests
+    -> Random sweeps and verification are pipelined (blockPipeline): RNG fills overlap writes, and read-back overlaps comparison (--queue-depth)
+    -> Rewrote the unlink stage: attributes and mode are stripped through the open fd, then the file is renamed and unlinked via its parent dirfd
+    -> Removed the two 50 ms sleeps and fileMutex; renames stay inside the file's own directory (no cross-device move into the temp directory)
+    -> Parent directories are fsynced once per batch (after each directory, and at exit) instead of sleeping per file
+    -> Recursive mode walks trees with fdopendir/readdir and fstatat relative to directory fds, classifying entries by d_type
+    -> Each file is stat'ed once; the result (fileInfo) is carried through the worker pool into shredFile(), hasWritePermission() and getOptimalBlockSize()
+    -> Device hints (sysfs queue limits, RAID stripe, rotational) are cached per device instead of being re-read for every file
+    -> Added --stats: per-phase time/bytes (RNG, write, sync, verify read, hash, unlink), per-pass throughput, syscall/allocation counts and a per-file latency histogram
+    -> --stats prints a JSON report at exit and a live rate line every 2 seconds; --stats-file=PATH writes the report to a file instead (CSV if PATH ends in .csv)
+    -> Added --benchmark[=DIR]: builds synthetic corpora (tiny files, huge files, sparse files, a deep tree) and sweeps block size, passes, secure mode,
+       verification, RNG backend and jobs, reporting MB/s and files/s (defaults to /dev/shm so device speed is left out)
+    -> Added --sparse: only allocated extents are overwritten and verified (SEEK_DATA/SEEK_HOLE, FSCTL_QUERY_ALLOCATED_RANGES on Windows); holes stay holes
+    -> The extent map is queried again at the start of every pass, and ranges for --file-threads are split from the map instead of the file size
+    -> Added --from-file=FILE and --from-stdin: NUL-delimited paths (e.g., 'find -print0') are read one at a time and dispatched straight to the worker pool
+    -> Logging is asynchronous: lines are queued in a lock-free ring buffer and written by one thread, flushed once per batch instead of per line (std::endl)
+    -> Levels are filtered before messages are built (isLogged()), and progress/statistics lines go through the same writer so output stays ordered
+    -> Added --log-file=PATH: every message (INFO included) is also written there as a JSON line with time, level and thread
+    -> Added a buffer arena: pattern blocks are filled once per process and shared, random/verify/pipeline blocks are recycled between passes and files
+    -> Added --journal=PATH and --resume: finished files, completed passes/sweeps and a 1 GiB watermark for large files are recorded in batches,
+       so an interrupted run is resumed instead of restarted (records are NUL-terminated; a torn last record is ignored)
+    -> Added --wipe-free-space=MOUNT: free space is filled with preallocated (fallocate) 1 GiB files, halving on ENOSPC, which are shredded
+       through the normal pass engine and worker pool, and the aggregate throughput is reported
+    -> Added --hash=<sha256|blake3|xxh64> for hashed verification: built-in SHA-256, BLAKE3 (8-lane chunk compression) and XXH64 replace the
+       FNV-1a fallback of non-OpenSSL builds; OpenSSL builds keep EVP SHA-256 (SHA-NI) as the default, others default to BLAKE3
+    -> Recursive mode, permission checks and permission changes now use the shared filesystem core (Filesystem Core/fsCore.h): the tree is
+       walked by up to '-j' threads feeding the worker pool, credentials are read once per run, and chmod is skipped when the mode is right
+    -> Fixed --resume completing a torn last journal record (it is now cut off), which could mark the wrong file as shredded;
+       added --self-test, which runs a known-answer check of that recovery
+    -> '--block-size' is rounded up to a multiple of the page size, so direct I/O ranges no longer serialize on buffered fallbacks
+    -> --wipe-free-space: rejects --sparse (preallocated fill files read as holes), fills the last gap below 64 KiB with plain writes,
+       warns about free space left unfilled, and reports the bytes actually written
 To-do:
     -> Nothing.
 
 Current full compilation flags: -std=c++20 -DOPENSSL_FOUND -L/path/to/openssl/lib -I/path/to/openssl/include -lssl -lcrypto
 */
-const char VERSION[]{"10.7d"}; // Define program version for later use
+const char VERSION[]{"10.9o"}; // Define program version for later use
 const char CW_YEAR[]{"2025"}; // Define copyright year for later use
 
 #include <iostream>       // For console logging
@@ -74,6 +122,10 @@ const char CW_YEAR[]{"2025"}; // Define copyright year for later use
 #include <chrono>         // For time measurements
 #include <string>         // For string manipulation
 #include <mutex>          // For secure file name generation
+#include <atomic>         // For the shared error flag
+#include <condition_variable> // For the worker pool queue
+#include <deque>          // For the worker pool queue
+#include <unordered_set>  // For directories awaiting a batched sync
 #include <vector>         // For buffer storage
 #include <cstring>        // For std::memcpy
 #include <thread>         // For sleeping (std::this_thread::sleep_for)
@@ -83,9 +135,15 @@ const char CW_YEAR[]{"2025"}; // Define copyright year for later use
 #include <unordered_map>  // For unordered maps
 #include <functional>     // For lambda functions within maps
 #include <memory>         // For dynamic pointers
+#include <cstdint>        // For fixed-width keystream words
+#include <cstdio>         // For std::snprintf
+#include <sstream>        // For building the --stats report
+
+#include <cerrno>         // For errno checks on POSIX calls
 
 #ifdef __linux__
 #include <sys/statvfs.h>  // For block size retrieval
+#include <sys/random.h>   // For getrandom(2)
 #endif
 
 #ifdef _WIN32
@@ -94,9 +152,15 @@ const char CW_YEAR[]{"2025"}; // Define copyright year for later use
 #include <aclAPI.h>       // For file permissions
 #include <sddl.h>         // For security descriptor strings
 #include <bcrypt.h>       // For secure data generation via entropy
+#include <io.h>           // For _commit() on the journal
 #pragma comment(lib, "bcrypt.lib") // Links against bcrypt library
 #endif
 
+#ifdef __linux__
+#include <sys/sysmacros.h> // For major()/minor() of the backing device
+#include <sys/vfs.h>      // For detecting tmpfs benchmark directories (statfs)
+#endif
+
 #ifdef __APPLE__
 #include <sys/sysctl.h>   // System info
 #include <sys/mount.h>    // File system info
@@ -104,9 +168,11 @@ const char CW_YEAR[]{"2025"}; // Define copyright year for later use
 
 #if defined(__APPLE__) || defined(__linux__)
 #include <sys/stat.h>     // File information
+#include <dirent.h>       // For fd-relative directory traversal (fdopendir/readdir)
 #include <sys/xattr.h>    // Extended attributes
 #include <unistd.h>       // POSIX operations
 #include <fcntl.h>        // For secure random data generation from urandom
+#include "../Filesystem Core/fsCore.h" // Traversal, credentials and permission helpers shared with the File Mode Scripts
 #endif
 
 #ifdef OPENSSL_FOUND
@@ -119,10 +185,28 @@ const bool isOpenSSL{false}; // Boolean to determine if OpenSSL is found
 
 namespace fs = std::filesystem; // Makes linking commands from the 'std::filesystem' easier
 
+enum rngBackend { // Define valid random pattern engines for overwrite passes
+    RNG_KERNEL, // Every random byte comes straight from the OS entropy source
+    RNG_CHACHA, // ChaCha20 keystream seeded from the OS entropy source
+    RNG_AESCTR  // AES-256-CTR keystream seeded from the OS entropy source (OpenSSL builds only)
+};
+
+enum hashAlgo { // Define valid digests for hash-based verification
+    HASH_SHA256, // SHA-256 (OpenSSL EVP when available, so SHA-NI / ARMv8 SHA is used)
+    HASH_BLAKE3, // BLAKE3 (built in, 8 chunks per step)
+    HASH_XXH64   // XXH64 (built in, non-cryptographic)
+};
+#ifdef OPENSSL_FOUND
+const hashAlgo HASH_DEFAULT{HASH_SHA256}; // Hardware-accelerated through EVP
+#else
+const hashAlgo HASH_DEFAULT{HASH_BLAKE3}; // Faster than a portable SHA-256 without SHA instructions
+#endif
+
 // Script configuration (defaults; mutable only by parseArguments(...))
 struct config {
 private:
     friend std::vector<std::string> parseArguments(int argc, char* argv[]);
+    friend void runBenchmark(); // Sweeps the settings below between benchmark runs
 
     int overwriteCount{3}; // integer to indicate number of passes to shred the file
     bool recursive{false}; // boolean to indicate whether directories are shredded or just files
@@ -134,11 +218,98 @@ private:
     bool verify{true}; // boolean to indicate verification after shredding
     bool force_delete{false}; // boolean to indicate force delete attempt
     bool internal{false}; // boolean to indicate whether scripting information is revealed
+    bool direct_io{true}; // boolean to indicate whether overwrites bypass the page cache (direct I/O)
+    bool sparse{false}; // boolean to indicate whether only allocated extents are overwritten (holes are skipped)
+    rngBackend rng{RNG_CHACHA}; // random pattern engine used for random overwrite passes
+    hashAlgo hash{HASH_DEFAULT}; // digest used when verification re-hashes the file (kernel random data)
+    std::uintmax_t blockSize{0}; // I/O block size override in bytes (0 = determined per file by getOptimalBlockSize)
+    int jobs{1}; // integer to indicate number of files shredded concurrently
+    int deviceJobs{0}; // integer to indicate concurrent files per device (0 = 1 for rotational disks, otherwise unlimited)
+    int fileThreads{0}; // integer to indicate threads overwriting one file in parallel ranges (0 = automatic for large files)
+    int queueDepth{3}; // integer to indicate blocks in flight between the RNG/read stage and the write/compare stage (1 = no pipelining)
+    bool stats{false}; // boolean to indicate whether throughput/latency statistics are collected and reported
+    std::string statsFile{}; // path the statistics report is written to (empty = standard output)
+    bool benchmark{false}; // boolean to indicate whether the benchmark harness runs instead of shredding arguments
+    bool self_test{false}; // boolean to indicate whether the known-answer self-tests run instead of shredding arguments
+    std::string manifest{}; // NUL-delimited list of paths to shred ('-' = standard input, empty = none)
+    std::string logFile{}; // path of the structured (JSON lines) log (empty = console only)
+    std::string journal{}; // path of the resume journal (empty = no journal)
+    bool resume{false}; // boolean to indicate whether work recorded in the journal is skipped
+    std::string benchmarkDir{}; // directory the benchmark corpora are built in (empty = /dev/shm or the temp directory)
+    std::string wipeMount{}; // volume whose free space is wiped (empty = none)
 
     void updateCount(const int value) {
         overwriteCount = value;
     }
 
+    void updateBlockSize(const std::uintmax_t value) {
+        blockSize = value;
+    }
+
+    void updateJobs(const int value) {
+        jobs = value;
+    }
+
+    void updateDeviceJobs(const int value) {
+        deviceJobs = value;
+    }
+
+    void updateFileThreads(const int value) {
+        fileThreads = value;
+    }
+
+    void updateQueueDepth(const int value) {
+        queueDepth = value;
+    }
+
+    void updateStatsFile(const std::string& path) {
+        statsFile = path;
+        stats = true; // A report file implies --stats
+    }
+
+    void updateManifest(const std::string& path) {
+        manifest = path;
+    }
+
+    void updateLogFile(const std::string& path) {
+        logFile = path;
+    }
+
+    void updateJournal(const std::string& path) {
+        journal = path;
+    }
+
+    void updateWipeMount(const std::string& path) {
+        wipeMount = path;
+    }
+
+    void updateBenchmarkDir(const std::string& path) {
+        benchmarkDir = path;
+        benchmark = true;
+    }
+
+    bool updateRng(const std::string& name) { // Returns false if the backend name is not valid
+        std::string lowerName = name;
+        std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+
+        if (lowerName == "kernel") rng = RNG_KERNEL;
+        else if (lowerName == "chacha" || lowerName == "chacha20") rng = RNG_CHACHA;
+        else if (lowerName == "aesctr" || lowerName == "aes-ctr") rng = RNG_AESCTR;
+        else return false;
+        return true;
+    }
+
+    bool updateHash(const std::string& name) { // Returns false if the digest name is not valid
+        std::string lowerName = name;
+        std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+
+        if (lowerName == "sha256" || lowerName == "sha-256") hash = HASH_SHA256;
+        else if (lowerName == "blake3") hash = HASH_BLAKE3;
+        else if (lowerName == "xxh64" || lowerName == "xxhash") hash = HASH_XXH64;
+        else return false;
+        return true;
+    }
+
     void updateFlag(const std::string& name, bool value) {
         // Convert name to lowercase for case-insensitive comparison
         std::string lowerName = name;
@@ -153,6 +324,11 @@ private:
         else if (lowerName == "force_delete") force_delete = value;
         else if (lowerName == "internal") internal = value;
         else if (lowerName == "follow_symlinks") follow_symlinks = value;
+        else if (lowerName == "direct_io") direct_io = value;
+        else if (lowerName == "stats") stats = value;
+        else if (lowerName == "sparse") sparse = value;
+        else if (lowerName == "resume") resume = value;
+        else if (lowerName == "self_test") self_test = value;
         else std::cerr << "INTERNAL ERROR: \"'" + name + "' is not valid in the context of updateFlag()\"" << std::endl;
     }
 public:
@@ -165,13 +341,34 @@ public:
     const bool& isVerbose() const {return verbose;};
     const bool& isKeep_files() const {return keep_files;};
     const bool& isRecursive() const {return recursive;};
+    const bool& isDirect_io() const {return direct_io;};
+    const bool& isStats() const {return stats;};
+    const bool& isSparse() const {return sparse;};
     const int& getOverwriteCount() const {return overwriteCount;};
+    const rngBackend& getRng() const {return rng;};
+    const hashAlgo& getHash() const {return hash;};
+    const std::uintmax_t& getBlockSize() const {return blockSize;};
+    const int& getJobs() const {return jobs;};
+    const int& getDeviceJobs() const {return deviceJobs;};
+    const int& getFileThreads() const {return fileThreads;};
+    const int& getQueueDepth() const {return queueDepth;};
+    const std::string& getStatsFile() const {return statsFile;};
+    const bool& isBenchmark() const {return benchmark;};
+    const bool& isSelf_test() const {return self_test;};
+    const std::string& getManifest() const {return manifest;};
+    const std::string& getLogFile() const {return logFile;};
+    const std::string& getJournal() const {return journal;};
+    const bool& isResume() const {return resume;};
+    const std::string& getBenchmarkDir() const {return benchmarkDir;};
+    const std::string& getWipeMount() const {return wipeMount;};
 };
 
+struct fileInfo; // Metadata captured during traversal (defined below)
+
 // Write permission boolean(s) to indicate if the file being processed has write permissions
 struct wPerm {
 private:
-    friend int hasWritePermission(const fs::path& path);
+    friend int hasWritePermission(const fs::path& path, const fileInfo& info);
     friend bool changePermissions(const std::string &filePath);
 
     bool failedToRetrievePermissions{false}; // boolean to indicate if permissions were successfully retrieved
@@ -186,11 +383,14 @@ public:
     const bool& failedWritePerm() const {return failedToRetrievePermissions;} // read-only determination of failedToRetrievePermissions
 };
 
+class rawFile; // Raw overwrite handle (defined below)
+
 // Structure with boolean(s) associated with the --internal flag or script internal booleans
 struct internal {
 private:
-    friend bool shredFile(const fs::path& filePath);
-    friend int overwriteWithRandomData(std::string filePath, std::fstream& file, std::uintmax_t fileSize, int pass);
+    friend bool shredFile(const fs::path& filePath, fileInfo info);
+    friend int overwriteWithRandomData(std::string filePath, rawFile& file, std::uintmax_t fileSize, std::uintmax_t bufferSize, int threads, int pass, size_t resumeSweep, std::uintmax_t watermark, const std::string* journalKey);
+    friend void fillRandomData(unsigned char* data, size_t size);
 
     bool bufferSizePrinted{false}; // boolean to indicate if the buffer size was already printed
     bool wasFailedToUrandomPrinted{false}; // boolean to indicate if failure to open urandom was already printed
@@ -201,113 +401,1157 @@ public:
     const bool& wasFailedUrandomPrinted() const {return wasFailedToUrandomPrinted;}
 };
 
-// Structure with boolean(s) associated with program functionality / success
-struct pgrm {
-private:
-    bool isProgramError{false};
-public:
-    void updateErrorStatus() {isProgramError = true;}
-    const bool& isError() const {return isProgramError;}
-};
+// Structure with boolean(s) associated with program functionality / success (shared by every worker)
+struct pgrm {
+private:
+    std::atomic<bool> isProgramError{false};
+public:
+    void updateErrorStatus() {isProgramError.store(true);}
+    bool isError() const {return isProgramError.load();}
+};
+
+enum statPhase { // Define the timed stages of a shred (--stats)
+    PHASE_RNG,         // Random pattern generation (keystream / entropy fills, including verification replay)
+    PHASE_WRITE,       // Overwrite transfers
+    PHASE_SYNC,        // Per-sweep fsync / F_FULLFSYNC / FlushFileBuffers barriers
+    PHASE_VERIFY_READ, // Read-back during verification
+    PHASE_HASH,        // Digest updates (kernel backend verification)
+    PHASE_UNLINK,      // Attribute stripping, rename and unlink
+    PHASE_COUNT
+};
+
+// Throughput and latency counters for --stats (relaxed atomics, so every worker thread records without locking)
+class shredStats {
+private:
+    static constexpr int LATENCY_BUCKETS{24}; // Per-file latency in power-of-two milliseconds (<1 ms, <2 ms, <4 ms ... )
+    static constexpr const char* PHASE_NAMES[PHASE_COUNT]{"rng", "write", "sync", "verify_read", "hash", "unlink"};
+
+    struct passTotal { // Totals for one pass number across every file
+        std::uint64_t bytes{}; // Bytes written by the pass (every sweep)
+        std::uint64_t nanos{}; // Time spent in the pass, verification included
+        std::uint64_t files{}; // Files that completed the pass
+    };
+
+    bool enabled{false}; // Set once by main() before any worker starts
+    std::atomic<std::uint64_t> phaseNanos[PHASE_COUNT]{};
+    std::atomic<std::uint64_t> phaseCalls[PHASE_COUNT]{};
+    std::atomic<std::uint64_t> phaseBytes[PHASE_COUNT]{};
+    std::atomic<std::uint64_t> syscalls{}; // System calls issued on the shred path (counted at the call sites)
+    std::atomic<std::uint64_t> allocations{}; // Aligned I/O buffer allocations
+    std::atomic<std::uint64_t> overwritten{}; // Bytes written by overwrite transfers (counted even without --stats, for the free-space report)
+    std::atomic<std::uint64_t> files{}; // Files shredded
+    std::atomic<std::uint64_t> maxFileNanos{}; // Slowest file
+    std::atomic<std::uint64_t> latency[LATENCY_BUCKETS]{};
+    std::mutex passMutex; // Guards passes (touched once per pass, not per block)
+    std::vector<passTotal> passes;
+
+    static double perSecond(std::uint64_t bytes, double seconds) { return seconds > 0 ? (bytes / 1048576.0) / seconds : 0.0; } // MiB/s
+
+    std::uint64_t percentileMs(double fraction) const { // Upper bound of the bucket holding the given fraction of files
+        std::uint64_t total{files.load(std::memory_order_relaxed)}, seen{};
+        if (total == 0) { return 0; }
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            seen += latency[b].load(std::memory_order_relaxed);
+            if (seen >= fraction * total) { return std::min<std::uint64_t>(1ULL << b, maxFileNanos.load(std::memory_order_relaxed) / 1000000 + 1); }
+        }
+        return maxFileNanos.load(std::memory_order_relaxed) / 1000000 + 1;
+    }
+
+public:
+    void enable() { enabled = true; }
+    bool isEnabled() const { return enabled; }
+
+    void addPhase(statPhase phase, std::uint64_t nanos, std::uint64_t bytes) {
+        phaseNanos[phase].fetch_add(nanos, std::memory_order_relaxed);
+        phaseCalls[phase].fetch_add(1, std::memory_order_relaxed);
+        phaseBytes[phase].fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void addSyscalls(std::uint64_t count = 1) { if (enabled) { syscalls.fetch_add(count, std::memory_order_relaxed); } }
+    void addAllocation() { if (enabled) { allocations.fetch_add(1, std::memory_order_relaxed); } }
+    void addOverwritten(std::uint64_t bytes) { overwritten.fetch_add(bytes, std::memory_order_relaxed); }
+
+    void addFile(std::uint64_t nanos) { // Records one shredded file's end-to-end latency
+        if (!enabled) { return; }
+        files.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t ms{nanos / 1000000};
+        int bucket{0};
+        while (ms > 0 && bucket < LATENCY_BUCKETS - 1) { ms >>= 1; ++bucket; }
+        latency[bucket].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t previous{maxFileNanos.load(std::memory_order_relaxed)};
+        while (nanos > previous && !maxFileNanos.compare_exchange_weak(previous, nanos, std::memory_order_relaxed)) {}
+    }
+
+    void addPass(int pass, std::uint64_t bytes, std::uint64_t nanos) {
+        if (!enabled || pass < 1) { return; }
+        std::lock_guard<std::mutex> guard(passMutex);
+        if (passes.size() < static_cast<size_t>(pass)) { passes.resize(pass); }
+        passes[pass - 1].bytes += bytes;
+        passes[pass - 1].nanos += nanos;
+        passes[pass - 1].files += 1;
+    }
+
+    std::uint64_t bytesWritten() const { return phaseBytes[PHASE_WRITE].load(std::memory_order_relaxed); }
+    std::uint64_t filesDone() const { return files.load(std::memory_order_relaxed); }
+    std::uint64_t overwrittenBytes() const { return overwritten.load(std::memory_order_relaxed); }
+
+    // Builds the end-of-run report; phase and pass times are summed across threads, so they can exceed the wall time
+    std::string report(double wallSeconds, bool csv) {
+        std::lock_guard<std::mutex> guard(passMutex);
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        const std::uint64_t written{bytesWritten()}, read{phaseBytes[PHASE_VERIFY_READ].load(std::memory_order_relaxed)};
+        if (csv) {
+            out << "record,name,count,bytes,seconds,mib_per_s\n";
+            out << "summary,total," << filesDone() << ',' << written << ',' << wallSeconds << ',' << perSecond(written, wallSeconds) << '\n';
+            out << "summary,verify_read,," << read << ",," << '\n';
+            out << "summary,syscalls," << syscalls.load(std::memory_order_relaxed) << ",,,\n";
+            out << "summary,allocations," << allocations.load(std::memory_order_relaxed) << ",,,\n";
+            for (int p = 0; p < PHASE_COUNT; ++p) {
+                double seconds{phaseNanos[p].load(std::memory_order_relaxed) / 1e9};
+                std::uint64_t bytes{phaseBytes[p].load(std::memory_order_relaxed)};
+                out << "phase," << PHASE_NAMES[p] << ',' << phaseCalls[p].load(std::memory_order_relaxed) << ',' << bytes << ',' << seconds << ',' << perSecond(bytes, seconds) << '\n';
+            }
+            for (size_t p = 0; p < passes.size(); ++p) {
+                double seconds{passes[p].nanos / 1e9};
+                out << "pass," << p + 1 << ',' << passes[p].files << ',' << passes[p].bytes << ',' << seconds << ',' << perSecond(passes[p].bytes, seconds) << '\n';
+            }
+            for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+                if (latency[b].load(std::memory_order_relaxed) == 0) { continue; }
+                out << "latency,le_" << (1ULL << b) << "ms," << latency[b].load(std::memory_order_relaxed) << ",,,\n";
+            }
+            return out.str();
+        }
+        out << "{\n";
+        out << "  \"version\": \"" << VERSION << "\",\n";
+        out << "  \"wall_seconds\": " << wallSeconds << ",\n";
+        out << "  \"files\": " << filesDone() << ",\n";
+        out << "  \"bytes_written\": " << written << ",\n";
+        out << "  \"bytes_read\": " << read << ",\n";
+        out << "  \"write_mib_per_s\": " << perSecond(written, wallSeconds) << ",\n";
+        out << "  \"syscalls\": " << syscalls.load(std::memory_order_relaxed) << ",\n";
+        out << "  \"allocations\": " << allocations.load(std::memory_order_relaxed) << ",\n";
+        out << "  \"phases\": {\n";
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            double seconds{phaseNanos[p].load(std::memory_order_relaxed) / 1e9};
+            std::uint64_t bytes{phaseBytes[p].load(std::memory_order_relaxed)};
+            out << "    \"" << PHASE_NAMES[p] << "\": {\"seconds\": " << seconds << ", \"calls\": " << phaseCalls[p].load(std::memory_order_relaxed)
+                << ", \"bytes\": " << bytes << ", \"mib_per_s\": " << perSecond(bytes, seconds) << "}" << (p + 1 < PHASE_COUNT ? "," : "") << "\n";
+        }
+        out << "  },\n";
+        out << "  \"passes\": [";
+        for (size_t p = 0; p < passes.size(); ++p) {
+            double seconds{passes[p].nanos / 1e9};
+            out << (p ? ",\n" : "\n") << "    {\"pass\": " << p + 1 << ", \"files\": " << passes[p].files << ", \"bytes\": " << passes[p].bytes
+                << ", \"seconds\": " << seconds << ", \"mib_per_s\": " << perSecond(passes[p].bytes, seconds) << "}";
+        }
+        out << (passes.empty() ? "],\n" : "\n  ],\n");
+        out << "  \"file_latency_ms\": {\"p50\": " << percentileMs(0.50) << ", \"p90\": " << percentileMs(0.90) << ", \"p99\": " << percentileMs(0.99)
+            << ", \"max\": " << maxFileNanos.load(std::memory_order_relaxed) / 1e6 << ", \"histogram\": [";
+        bool first{true};
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            if (latency[b].load(std::memory_order_relaxed) == 0) { continue; }
+            out << (first ? "" : ", ") << "{\"le_ms\": " << (1ULL << b) << ", \"count\": " << latency[b].load(std::memory_order_relaxed) << "}";
+            first = false;
+        }
+        out << "]}\n}\n";
+        return out.str();
+    }
+};
+
+shredStats Stats; // Declared here so the I/O classes below can record into it
+
+// Times one stage into Stats for the lifetime of the object (no clock reads unless --stats is on)
+class phaseTimer {
+private:
+    statPhase phase;
+    std::uint64_t bytes;
+    bool active;
+    std::chrono::steady_clock::time_point start{};
+public:
+    phaseTimer(statPhase p, std::uint64_t b = 0) : phase(p), bytes(b), active(Stats.isEnabled()) { if (active) { start = std::chrono::steady_clock::now(); } }
+    ~phaseTimer() { if (active) { Stats.addPhase(phase, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()), bytes); } }
+    phaseTimer(const phaseTimer&) = delete;
+    phaseTimer& operator=(const phaseTimer&) = delete;
+};
+
+// Secure random data generation class (opened once for the lifetime of the program, fills caller-supplied buffers in place)
+class entropySource {
+private:
+#if defined(__APPLE__) || defined(__linux__)
+    int urandomFd{-1}; // Held file descriptor for /dev/urandom (used when getrandom(2) is unavailable)
+#endif
+#ifndef OPENSSL_FOUND
+    std::random_device rd; // Seeds the Mersenne Twister fallback
+    std::mt19937 gen; // Mersenne Twister fallback (non-OpenSSL builds only)
+    std::chrono::steady_clock::time_point lastSeedTime; // Time the fallback was last seeded
+#endif
+    std::mutex fallbackMutex; // Guards the fallback generator
+
+public:
+#ifndef OPENSSL_FOUND
+    entropySource() : gen(rd()), lastSeedTime(std::chrono::steady_clock::now()) { openSource(); }
+#else
+    entropySource() { openSource(); }
+#endif
+    ~entropySource() {
+#if defined(__APPLE__) || defined(__linux__)
+        if (urandomFd != -1) { close(urandomFd); }
+#endif
+    }
+    entropySource(const entropySource&) = delete;
+    entropySource& operator=(const entropySource&) = delete;
+
+    void openSource() {
+#if defined(__APPLE__) || defined(__linux__)
+        urandomFd = open("/dev/urandom", O_RDONLY | O_CLOEXEC); // Opened once, reused by every fill()
+#endif
+    }
+
+    // Fills 'size' bytes at 'data' from the OS entropy source (one syscall per call in the common case)
+    void fill(unsigned char* data, size_t size) {
+#ifdef _WIN32
+        NTSTATUS status = BCryptGenRandom(
+            NULL,                           // Use default RNG algorithm
+            data,                           // Destination buffer
+            static_cast<ULONG>(size),       // Buffer size
+            BCRYPT_USE_SYSTEM_PREFERRED_RNG // Use system RNG
+        );
+        if (status != STATUS_SUCCESS) {
+            throw std::runtime_error("BCryptGenRandom failed to generate secure random data. Attempting fallback " + std::string(isOpenSSL ? "OpenSSL RAND_BYTES..." : "Mersenne Twister..."));
+        }
+#else
+        size_t filled{};
+        while (filled < size) {
+            ssize_t got{-1};
+#ifdef __linux__
+            got = getrandom(data + filled, size - filled, 0); // No file descriptor needed
+            if (got == -1 && errno == EINTR) { continue; }
+            if (got == -1 && errno == ENOSYS && urandomFd != -1) { got = read(urandomFd, data + filled, size - filled); } // Old kernels
+#else
+            if (urandomFd == -1) {
+                throw std::runtime_error("Failed to open /dev/urandom for secure random data generation. Attempting fallback " + std::string(isOpenSSL ? "OpenSSL RAND_BYTES..." : "Mersenne Twister..."));
+            }
+            got = read(urandomFd, data + filled, size - filled); // Read from the held descriptor
+            if (got == -1 && errno == EINTR) { continue; }
+#endif
+            if (got <= 0) {
+                throw std::runtime_error("Failed to read random data from the system entropy source. Attempting fallback " + std::string(isOpenSSL ? "OpenSSL RAND_BYTES..." : "Mersenne Twister..."));
+            }
+            filled += static_cast<size_t>(got);
+        }
+#endif
+    }
+
+    // Fills 'size' bytes at 'data' from the fallback generator (OpenSSL RAND_bytes or a reseeded Mersenne Twister)
+    void fallbackFill(unsigned char* data, size_t size) {
+        std::lock_guard<std::mutex> lock(fallbackMutex);
+#ifdef OPENSSL_FOUND
+        // OpenSSL automatically handles reseeding of its entropy pool.
+        if (RAND_bytes(data, static_cast<int>(size)) != 1) {
+            throw std::runtime_error("Failed to generate secure random bytes using OpenSSL RAND_bytes.");
+        }
+#else
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastSeedTime).count() >= 3) { // Reseed if last seeding was over 3 seconds ago
+            gen.seed(rd());
+            lastSeedTime = now;
+        }
+        std::uniform_int_distribution<> dist(0, 255); // Sets even distribution for data generation
+        std::generate(data, data + size, [&](){ return static_cast<unsigned char>(dist(gen)); });
+#endif
+    }
+};
+
+// Page-aligned heap buffer for I/O (std::vector can't guarantee the alignment the kernel prefers for large transfers)
+class alignedBuffer {
+private:
+    unsigned char* ptr{nullptr}; // Aligned allocation
+    size_t len{}; // Usable size in bytes
+
+public:
+    static size_t pageSize() { // Returns the system memory page size
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        long size{sysconf(_SC_PAGESIZE)};
+        return size > 0 ? static_cast<size_t>(size) : 4096;
+#endif
+    }
+
+    alignedBuffer() = default;
+    explicit alignedBuffer(size_t size, size_t alignment = pageSize()) : len(size) {
+        Stats.addAllocation();
+        size_t allocSize{((size + alignment - 1) / alignment) * alignment}; // Rounded up so the tail stays aligned too
+        if (allocSize == 0) { allocSize = alignment; }
+#ifdef _WIN32
+        ptr = static_cast<unsigned char*>(_aligned_malloc(allocSize, alignment));
+        if (!ptr) { throw std::bad_alloc(); }
+#else
+        void* mem{nullptr};
+        if (posix_memalign(&mem, alignment, allocSize) != 0) { throw std::bad_alloc(); }
+        ptr = static_cast<unsigned char*>(mem);
+#endif
+    }
+    ~alignedBuffer() { release(); }
+    alignedBuffer(const alignedBuffer&) = delete;
+    alignedBuffer& operator=(const alignedBuffer&) = delete;
+    alignedBuffer(alignedBuffer&& other) noexcept : ptr(other.ptr), len(other.len) { other.ptr = nullptr; other.len = 0; }
+    alignedBuffer& operator=(alignedBuffer&& other) noexcept {
+        if (this != &other) { release(); ptr = other.ptr; len = other.len; other.ptr = nullptr; other.len = 0; }
+        return *this;
+    }
+
+    void release() {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+        ptr = nullptr;
+        len = 0;
+    }
+
+    unsigned char* data() {return ptr;}
+    const unsigned char* data() const {return ptr;}
+    const size_t& size() const {return len;}
+};
+
+// Process-wide store of I/O blocks: pattern blocks are filled once and shared read-only, scratch blocks (random data,
+// read-back, pipeline slots) are handed back on release and reused by the next pass or file instead of reallocated
+class bufferArena {
+private:
+    static constexpr std::uintmax_t RETAIN_LIMIT{256ull * 1024 * 1024}; // Spare bytes kept around (beyond this, releases free)
+    std::mutex lock;
+    std::unordered_map<size_t, std::vector<alignedBuffer>> spare; // Released scratch blocks by size
+    std::unordered_map<std::uintmax_t, alignedBuffer> patterns; // Filled pattern blocks by (size << 8 | byte), kept for the process
+    std::uintmax_t retained{}; // Bytes currently held in spare
+
+public:
+    alignedBuffer acquire(size_t size) { // Reuses a released block of the same size or allocates a new one
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it{spare.find(size)};
+            if (it != spare.end() && !it->second.empty()) {
+                alignedBuffer block{std::move(it->second.back())};
+                it->second.pop_back();
+                retained -= size;
+                return block;
+            }
+        }
+        return alignedBuffer(size); // Allocated outside the lock
+    }
+
+    void release(alignedBuffer&& block) { // Keeps the block for the next acquire of its size
+        if (!block.data()) { return; }
+        std::lock_guard<std::mutex> guard(lock);
+        if (retained + block.size() > RETAIN_LIMIT) { return; } // Freed by the caller's destructor
+        retained += block.size();
+        spare[block.size()].push_back(std::move(block));
+    }
+
+    const unsigned char* pattern(unsigned char byte, size_t size) { // Block of 'size' bytes of 'byte', filled on first use
+        std::lock_guard<std::mutex> guard(lock);
+        alignedBuffer& block{patterns[(static_cast<std::uintmax_t>(size) << 8) | byte]};
+        if (!block.data()) {
+            block = alignedBuffer(size);
+            std::memset(block.data(), byte, size);
+        }
+        return block.data(); // Address stays valid for the process (blocks are never released or refilled)
+    }
+};
+
+bufferArena Arena; // Shared by every worker and range thread
+
+// Scratch block borrowed from Arena for the lifetime of the object
+class pooledBuffer {
+private:
+    alignedBuffer block;
+
+public:
+    explicit pooledBuffer(size_t size) : block(Arena.acquire(size)) {}
+    ~pooledBuffer() { Arena.release(std::move(block)); }
+    pooledBuffer(const pooledBuffer&) = delete;
+    pooledBuffer& operator=(const pooledBuffer&) = delete;
+
+    unsigned char* data() {return block.data();}
+    const unsigned char* data() const {return block.data();}
+    const size_t& size() const {return block.size();}
+};
+
+// I/O geometry of the device backing a file (used to size overwrite buffers)
+struct ioGeometry {
+    std::uintmax_t blockSize{}; // Chosen transfer size for each read/write
+    std::uintmax_t fsBlockSize{}; // Preferred file system I/O size (st_blksize / f_iosize / cluster size)
+    std::uintmax_t deviceOptimal{}; // Device optimal I/O size (0 if unknown)
+    std::uintmax_t stripeWidth{}; // RAID stripe width (0 if not striped or unknown)
+    bool overridden{false}; // Set by '--block-size'
+    bool rotational{false}; // Backing device is a spinning disk (ranges are not split)
+};
+
+// Metadata of a file, captured with a single stat (during traversal when possible) and carried into its shred job
+struct fileInfo {
+    std::uintmax_t size{}; // File size in bytes
+    std::uintmax_t device{}; // Backing device (st_dev, or a hash of the volume on Windows)
+    std::uintmax_t blockSize{}; // Preferred I/O size of the file system (st_blksize, 0 if unknown)
+    unsigned int mode{}; // Type and permission bits (st_mode, 0 on Windows)
+    unsigned int uid{}; // Owner
+    unsigned int gid{}; // Group
+    bool symlink{false}; // Reached through a symbolic link
+    bool known{false}; // Filled in (otherwise statFile() is called by shredFile())
+};
+
+// Raw file handle for overwrite passes (direct I/O where the platform and alignment allow it, buffered otherwise)
+class rawFile {
+private:
+#ifdef _WIN32
+    HANDLE handle{INVALID_HANDLE_VALUE}; // Main handle (unbuffered and write-through when direct)
+    HANDLE bufferedHandle{INVALID_HANDLE_VALUE}; // Buffered handle for transfers that can't meet the alignment
+#else
+    int fd{-1}; // File descriptor
+#endif
+    std::atomic<bool> direct{false}; // Whether transfers bypass the page cache (ranges of one file may be written from several threads)
+    std::atomic<size_t> alignment{1}; // Required alignment of buffer address, offset and length for direct transfers
+    std::mutex modeLock; // Serializes transfers that temporarily drop O_DIRECT
+
+    bool isAligned(const unsigned char* data, size_t size, std::uintmax_t offset) const {
+        return (reinterpret_cast<std::uintptr_t>(data) % alignment == 0) && (size % alignment == 0) && (offset % alignment == 0);
+    }
+#ifdef __linux__
+    bool setDirect(bool enable) { // Toggles O_DIRECT on the open descriptor
+        int flags{fcntl(fd, F_GETFL)};
+        if (flags == -1) { return false; }
+        flags = enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+        return fcntl(fd, F_SETFL, flags) == 0;
+    }
+#endif
+
+    bool transfer(unsigned char* data, size_t size, std::uintmax_t offset, bool writing) { // Positioned read or write of exactly 'size' bytes
+        phaseTimer timer(writing ? PHASE_WRITE : PHASE_VERIFY_READ, size); // Reads only happen during verification
+#ifdef _WIN32
+        HANDLE target{(direct && !isAligned(data, size, offset) && bufferedHandle != INVALID_HANDLE_VALUE) ? bufferedHandle : handle};
+        while (size > 0) {
+            OVERLAPPED ov{}; // Carries the offset for positioned I/O on a synchronous handle
+            ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+            ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD chunk{static_cast<DWORD>(std::min<size_t>(size, 1 << 30))}, done{};
+            BOOL ok{writing ? WriteFile(target, data, chunk, &done, &ov) : ReadFile(target, data, chunk, &done, &ov)};
+            Stats.addSyscalls();
+            if (!ok || done == 0) { return false; }
+            if (writing) { Stats.addOverwritten(done); }
+            data += done; size -= done; offset += done;
+        }
+        return true;
+#else
+        bool toggled{false};
+#ifdef __linux__
+        std::unique_lock<std::mutex> modeGuard(modeLock, std::defer_lock);
+        if (direct && !isAligned(data, size, offset)) { // Unaligned transfers (e.g., the tail) go through the page cache
+            modeGuard.lock();
+            toggled = setDirect(false);
+        }
+#endif
+        bool ok{true};
+        while (size > 0) {
+            ssize_t done{writing ? pwrite(fd, data, size, static_cast<off_t>(offset)) : pread(fd, data, size, static_cast<off_t>(offset))};
+            Stats.addSyscalls();
+            if (done == -1 && errno == EINTR) { continue; }
+#ifdef __linux__
+            if (done == -1 && errno == EINVAL && direct && !toggled && setDirect(false)) { // File system accepted O_DIRECT at open but not for transfers
+                direct = false;
+                alignment = 1;
+                continue;
+            }
+#endif
+            if (done <= 0) { ok = false; break; }
+            if (writing) { Stats.addOverwritten(static_cast<std::uint64_t>(done)); }
+            data += done; size -= static_cast<size_t>(done); offset += static_cast<std::uintmax_t>(done);
+        }
+#ifdef __linux__
+        if (toggled && direct) { setDirect(true); }
+#endif
+        return ok;
+#endif
+    }
+
+public:
+    rawFile() = default;
+    ~rawFile() { close(); }
+    rawFile(const rawFile&) = delete;
+    rawFile& operator=(const rawFile&) = delete;
+
+    bool open(const fs::path& path, bool wantDirect, bool noFollow = false) { // Opens for read/write; falls back to buffered I/O if direct I/O is refused
+        close();
+        Stats.addSyscalls();
+#ifdef _WIN32
+        (void)noFollow; // Links are filtered by the caller
+        const DWORD share{FILE_SHARE_READ | FILE_SHARE_WRITE};
+        if (wantDirect) {
+            handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, share, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, NULL);
+            if (handle != INVALID_HANDLE_VALUE) {
+                direct = true;
+                alignment = alignedBuffer::pageSize(); // A multiple of every common sector size
+                bufferedHandle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, share, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, NULL);
+                return true;
+            }
+        }
+        handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, share, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        return handle != INVALID_HANDLE_VALUE;
+#else
+#ifdef __linux__
+        if (wantDirect) {
+            fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | O_DIRECT | (noFollow ? O_NOFOLLOW : 0)); // Refused with EINVAL by file systems without direct I/O (e.g., tmpfs)
+            if (fd != -1) { direct = true; alignment = alignedBuffer::pageSize(); }
+        }
+#endif
+        if (fd == -1) { fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (noFollow ? O_NOFOLLOW : 0)); } // O_NOFOLLOW: fails if the path became a symlink
+        if (fd == -1) { return false; }
+#ifdef __APPLE__
+        if (wantDirect && fcntl(fd, F_NOCACHE, 1) == 0) { direct = true; } // Bypasses the unified buffer cache (no alignment requirements)
+#endif
+        return true;
+#endif
+    }
+
+    bool writeAt(const unsigned char* data, size_t size, std::uintmax_t offset) { return transfer(const_cast<unsigned char*>(data), size, offset, true); }
+    bool readAt(unsigned char* data, size_t size, std::uintmax_t offset) { return transfer(data, size, offset, false); }
+
+    bool sync() { // Forces written data to the device
+        phaseTimer timer(PHASE_SYNC);
+        Stats.addSyscalls();
+#ifdef _WIN32
+        bool ok{FlushFileBuffers(handle) != 0};
+        if (bufferedHandle != INVALID_HANDLE_VALUE) { ok = (FlushFileBuffers(bufferedHandle) != 0) && ok; }
+        return ok;
+#elif defined(__APPLE__)
+        if (fcntl(fd, F_FULLFSYNC) == 0) { return true; } // fsync() alone does not flush the drive cache on macOS
+        return fsync(fd) == 0;
+#else
+        return fsync(fd) == 0;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (bufferedHandle != INVALID_HANDLE_VALUE) { CloseHandle(bufferedHandle); bufferedHandle = INVALID_HANDLE_VALUE; }
+        if (handle != INVALID_HANDLE_VALUE) { CloseHandle(handle); handle = INVALID_HANDLE_VALUE; }
+#else
+        if (fd != -1) { ::close(fd); fd = -1; }
+#endif
+        direct = false;
+        alignment = 1;
+    }
+
+    bool isOpen() const {
+#ifdef _WIN32
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        return fd != -1;
+#endif
+    }
+    bool isDirect() const {return direct.load();}
+#ifdef _WIN32
+    HANDLE nativeHandle() const {return handle;} // For metadata calls on the open file
+#else
+    int nativeHandle() const {return fd;} // For metadata calls on the open file
+#endif
+};
+
+// Multi-buffered hand-off between two stages of a sweep: the caller fills blocks (RNG or read-back) while a
+// stage thread consumes them (write or compare), so generation and I/O overlap with 'depth' blocks in flight
+class blockPipeline {
+private:
+    struct slot {
+        pooledBuffer buffer; // Block storage (page aligned for direct I/O, recycled through Arena)
+        size_t size{}; // Bytes used in this block
+        std::uintmax_t offset{}; // File offset of the block
+        explicit slot(size_t blockSize) : buffer(blockSize) {}
+    };
+
+    std::deque<slot> slots; // Ring of buffers (deque keeps addresses stable)
+    std::deque<size_t> freeSlots; // Buffers the producer can fill
+    std::deque<size_t> filledSlots; // Buffers waiting for the stage thread, in submission order
+    size_t current{}; // Buffer handed out by the last acquire()
+    std::mutex lock;
+    std::condition_variable changed;
+    bool closed{false}; // Producer is done
+    bool failed{false}; // Stage reported a failure (producer should stop)
+    std::function<bool(const unsigned char*, size_t, std::uintmax_t)> stage; // Consumer (returns false to stop the pipeline)
+    std::thread worker;
+
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            changed.wait(guard, [&]() { return !filledSlots.empty() || closed; });
+            if (filledSlots.empty()) { return; } // Closed and drained
+            size_t index{filledSlots.front()};
+            filledSlots.pop_front();
+            guard.unlock();
+
+            bool ok{false};
+            try { ok = stage(slots[index].buffer.data(), slots[index].size, slots[index].offset); } catch (...) { ok = false; }
+
+            guard.lock();
+            freeSlots.push_back(index);
+            if (!ok) { failed = true; }
+            changed.notify_all();
+            if (failed) { return; }
+        }
+    }
+
+public:
+    blockPipeline(size_t depth, size_t blockSize, std::function<bool(const unsigned char*, size_t, std::uintmax_t)> consumer) : stage(std::move(consumer)) {
+        for (size_t index = 0; index < depth; ++index) {
+            slots.emplace_back(blockSize);
+            freeSlots.push_back(index);
+        }
+        worker = std::thread(&blockPipeline::run, this);
+    }
+    ~blockPipeline() { finish(); }
+    blockPipeline(const blockPipeline&) = delete;
+    blockPipeline& operator=(const blockPipeline&) = delete;
+
+    unsigned char* acquire() { // Waits for a free buffer (nullptr once the stage has failed)
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&]() { return !freeSlots.empty() || failed; });
+        if (failed) { return nullptr; }
+        current = freeSlots.front();
+        freeSlots.pop_front();
+        return slots[current].buffer.data();
+    }
+
+    void submit(size_t size, std::uintmax_t offset) { // Queues the acquired buffer for the stage thread
+        std::lock_guard<std::mutex> guard(lock);
+        slots[current].size = size;
+        slots[current].offset = offset;
+        filledSlots.push_back(current);
+        changed.notify_all();
+    }
+
+    bool finish() { // Drains the queue and joins the stage thread; false if the stage failed
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed = true;
+        }
+        changed.notify_all();
+        if (worker.joinable()) { worker.join(); }
+        return !failed;
+    }
+};
+
+// One sequential sweep of an overwrite pass
+struct sweepSpec {
+    bool random; // Random data (true) or a fixed byte pattern (false)
+    bool final; // Final random data of the pass (the data that is verified)
+    unsigned char pattern; // Byte written by pattern sweeps
+};
+
+// Byte range of a file written by one thread (large files are split into ranges that are overwritten in parallel)
+struct extent {
+    std::uintmax_t offset; // First byte of the range (block- or file system block-aligned, so direct I/O stays aligned)
+    std::uintmax_t length; // Bytes in the range
+};
+
+void fillRandomData(unsigned char* data, size_t size); // Declared early for the kernel keystream backend
+
+// Key and nonce for a keystream (drawn from the OS entropy source, kept so a pass can be replayed)
+struct keystreamSeed {
+    unsigned char key[32]{}; // 256-bit cipher key
+    unsigned char nonce[16]{}; // ChaCha20 uses the first 8 bytes, AES-256-CTR uses all 16 as the initial counter block
+};
+
+// Random pattern engine for overwrite passes (kernel entropy, or a ChaCha20 / AES-256-CTR keystream seeded from it)
+class keystream {
+private:
+    rngBackend backend{RNG_KERNEL}; // Selected engine
+    uint32_t state[16]{}; // Portable ChaCha20 state (constants, key, 64-bit block counter, 64-bit nonce)
+    unsigned char leftover[512]{}; // Unused keystream from the last batch of 8 blocks
+    size_t leftoverPos{sizeof(leftover)}; // Read position within leftover (empty when equal to its size)
+#ifdef OPENSSL_FOUND
+    EVP_CIPHER_CTX* ctx{nullptr}; // EVP cipher context (uses AES-NI / SIMD ChaCha20 where the CPU has them)
+#endif
+
+    static uint32_t load32(const unsigned char* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+    static uint32_t rotl32(uint32_t v, int c) { return (v << c) | (v >> (32 - c)); }
+
+    // Generates 8 consecutive ChaCha20 blocks (512 bytes) into out; lanes are interleaved so the loops vectorize
+    void chachaBlocks(unsigned char* out) {
+        uint32_t x[16][8];
+        uint64_t counter{uint64_t(state[12]) | (uint64_t(state[13]) << 32)};
+        for (int i = 0; i < 16; ++i) { for (int l = 0; l < 8; ++l) { x[i][l] = state[i]; } }
+        for (int l = 0; l < 8; ++l) { x[12][l] = uint32_t(counter + l); x[13][l] = uint32_t((counter + l) >> 32); }
+        uint32_t in12[8], in13[8];
+        for (int l = 0; l < 8; ++l) { in12[l] = x[12][l]; in13[l] = x[13][l]; }
+
+        auto quarterRound = [&](int a, int b, int c, int d) {
+            for (int l = 0; l < 8; ++l) {
+                x[a][l] += x[b][l]; x[d][l] = rotl32(x[d][l] ^ x[a][l], 16);
+                x[c][l] += x[d][l]; x[b][l] = rotl32(x[b][l] ^ x[c][l], 12);
+                x[a][l] += x[b][l]; x[d][l] = rotl32(x[d][l] ^ x[a][l], 8);
+                x[c][l] += x[d][l]; x[b][l] = rotl32(x[b][l] ^ x[c][l], 7);
+            }
+        };
+        for (int round = 0; round < 10; ++round) { // 20 rounds (10 column + 10 diagonal)
+            quarterRound(0, 4, 8, 12); quarterRound(1, 5, 9, 13); quarterRound(2, 6, 10, 14); quarterRound(3, 7, 11, 15);
+            quarterRound(0, 5, 10, 15); quarterRound(1, 6, 11, 12); quarterRound(2, 7, 8, 13); quarterRound(3, 4, 9, 14);
+        }
+        for (int l = 0; l < 8; ++l) {
+            for (int i = 0; i < 16; ++i) {
+                uint32_t v{x[i][l] + (i == 12 ? in12[l] : (i == 13 ? in13[l] : state[i]))};
+                unsigned char* o{out + l * 64 + i * 4};
+                o[0] = static_cast<unsigned char>(v); o[1] = static_cast<unsigned char>(v >> 8);
+                o[2] = static_cast<unsigned char>(v >> 16); o[3] = static_cast<unsigned char>(v >> 24);
+            }
+        }
+        counter += 8;
+        state[12] = uint32_t(counter); state[13] = uint32_t(counter >> 32);
+    }
+
+    void portableFill(unsigned char* data, size_t size) {
+        while (size > 0) {
+            if (leftoverPos < sizeof(leftover)) { // Drain what is left from the previous batch first
+                size_t take{std::min(size, sizeof(leftover) - leftoverPos)};
+                std::memcpy(data, leftover + leftoverPos, take);
+                leftoverPos += take; data += take; size -= take;
+            } else if (size >= sizeof(leftover)) { // Generate straight into the caller's buffer
+                chachaBlocks(data);
+                data += sizeof(leftover); size -= sizeof(leftover);
+            } else {
+                chachaBlocks(leftover);
+                leftoverPos = 0;
+            }
+        }
+    }
+
+public:
+    explicit keystream(rngBackend engine) : backend(engine) {}
+    ~keystream() {
+#ifdef OPENSSL_FOUND
+        if (ctx) { EVP_CIPHER_CTX_free(ctx); }
+#endif
+    }
+    keystream(const keystream&) = delete;
+    keystream& operator=(const keystream&) = delete;
+
+    const rngBackend& getBackend() const {return backend;}
+
+    // (Re)starts the keystream from a seed; does nothing for the kernel backend
+    void start(const keystreamSeed& seed) {
+        if (backend == RNG_KERNEL) { return; }
+#ifdef OPENSSL_FOUND
+        if (!ctx) { ctx = EVP_CIPHER_CTX_new(); }
+        unsigned char iv[16]{}; // ChaCha20: 64-bit little-endian block counter then 64-bit nonce; AES-CTR: full counter block
+        if (backend == RNG_CHACHA) { std::memcpy(iv + 8, seed.nonce, 8); } else { std::memcpy(iv, seed.nonce, 16); }
+        if (ctx && EVP_EncryptInit_ex(ctx, backend == RNG_CHACHA ? EVP_chacha20() : EVP_aes_256_ctr(), nullptr, seed.key, iv) == 1) {
+            return;
+        }
+        if (ctx) { EVP_CIPHER_CTX_free(ctx); ctx = nullptr; }
+        backend = RNG_CHACHA; // The portable engine below is used if EVP is not usable
+#endif
+        static const char sigma[]{"expand 32-byte k"};
+        for (int i = 0; i < 4; ++i) { state[i] = load32(reinterpret_cast<const unsigned char*>(sigma) + i * 4); }
+        for (int i = 0; i < 8; ++i) { state[4 + i] = load32(seed.key + i * 4); }
+        state[12] = 0; state[13] = 0; // 64-bit block counter
+        state[14] = load32(seed.nonce); state[15] = load32(seed.nonce + 4); // 64-bit nonce
+        leftoverPos = sizeof(leftover);
+    }
+
+    // Fills 'size' bytes at 'data' with the next bytes of the keystream
+    void fill(unsigned char* data, size_t size) {
+        phaseTimer timer(PHASE_RNG, size);
+        if (backend == RNG_KERNEL) { fillRandomData(data, size); return; }
+#ifdef OPENSSL_FOUND
+        if (ctx) { // Encrypting zeros with a stream cipher yields the raw keystream
+            std::memset(data, 0, size);
+            while (size > 0) {
+                int chunk{static_cast<int>(std::min<size_t>(size, 1 << 30))}, outLen{};
+                if (EVP_EncryptUpdate(ctx, data, &outLen, data, chunk) != 1) { throw std::runtime_error("OpenSSL failed to generate keystream data."); }
+                data += chunk; size -= chunk;
+            }
+            return;
+        }
+#endif
+        portableFill(data, size);
+    }
+};
+
+// Portable SHA-256 (FIPS 180-4) for builds without OpenSSL
+class sha256Portable {
+private:
+    uint32_t h[8]{};
+    unsigned char block[64]{};
+    size_t blockLen{};
+    uint64_t totalLen{}; // Bytes hashed so far
+
+    static uint32_t rotr32(uint32_t v, int c) { return (v >> c) | (v << (32 - c)); }
+
+    void compress(const unsigned char* p) {
+        static const uint32_t k[64]{
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+            0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+            0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+            0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) { w[i] = (uint32_t(p[i * 4]) << 24) | (uint32_t(p[i * 4 + 1]) << 16) | (uint32_t(p[i * 4 + 2]) << 8) | uint32_t(p[i * 4 + 3]); }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0{rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3)};
+            uint32_t s1{rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10)};
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a{h[0]}, b{h[1]}, c{h[2]}, d{h[3]}, e{h[4]}, f{h[5]}, g{h[6]}, hh{h[7]};
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1{hh + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i]};
+            uint32_t t2{(rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c))};
+            hh = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+
+public:
+    void reset() {
+        static const uint32_t iv[8]{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        std::memcpy(h, iv, sizeof(h));
+        blockLen = 0;
+        totalLen = 0;
+    }
+
+    void update(const unsigned char* data, size_t size) {
+        totalLen += size;
+        if (blockLen > 0) { // Tops up a partial block first
+            size_t take{std::min(size, sizeof(block) - blockLen)};
+            std::memcpy(block + blockLen, data, take);
+            blockLen += take; data += take; size -= take;
+            if (blockLen < sizeof(block)) { return; }
+            compress(block);
+            blockLen = 0;
+        }
+        for (; size >= 64; data += 64, size -= 64) { compress(data); } // Whole blocks straight from the caller's buffer
+        std::memcpy(block, data, size);
+        blockLen = size;
+    }
+
+    std::vector<unsigned char> finish() {
+        uint64_t bits{totalLen * 8};
+        unsigned char pad[72]{0x80}; // 0x80, zeros, then the 64-bit big-endian length
+        size_t padLen{(blockLen < 56 ? 56 : 120) - blockLen};
+        for (int i = 0; i < 8; ++i) { pad[padLen + i] = static_cast<unsigned char>(bits >> (56 - i * 8)); }
+        update(pad, padLen + 8);
+        std::vector<unsigned char> out(32);
+        for (int i = 0; i < 32; ++i) { out[i] = static_cast<unsigned char>(h[i / 4] >> (24 - (i % 4) * 8)); }
+        return out;
+    }
+};
+
+// BLAKE3 (hash mode, 32-byte output); chunks are compressed 8 at a time in interleaved lanes so the loops vectorize
+class blake3Hasher {
+private:
+    static constexpr uint32_t CHUNK_START{1}, CHUNK_END{2}, PARENT{4}, ROOT{8}; // Domain flags
+    static constexpr size_t CHUNK_LEN{1024};
+    static constexpr int LANES{8}; // Chunks compressed together by compressChunks()
+    static constexpr int SCHEDULE[7][16]{ // Message word order of every round (the message permutation applied repeatedly)
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+        {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1}, {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+        {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4}, {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+        {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13}};
+
+    uint32_t cvStack[54][8]{}; // Chaining values of completed subtrees (enough for 2^64 bytes)
+    size_t stackLen{};
+    uint64_t chunkCounter{}; // Index of the chunk being filled
+    uint32_t cv[8]{}; // Chaining value of the current chunk
+    unsigned char block[64]{}; // Buffered block of the current chunk
+    size_t blockLen{};
+    size_t blocksCompressed{}; // Blocks of the current chunk already compressed
+
+    static const uint32_t* iv() {
+        static const uint32_t value[8]{0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+        return value;
+    }
+    static uint32_t load32(const unsigned char* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+    static uint32_t rotr32(uint32_t v, int c) { return (v >> c) | (v << (32 - c)); }
+
+    // Compresses one block; writes all 16 output words (the first 8 are the new chaining value)
+    static void compress(const uint32_t in[8], const uint32_t m[16], uint64_t counter, uint32_t length, uint32_t flags, uint32_t out[16]) {
+        uint32_t s[16]{in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7], iv()[0], iv()[1], iv()[2], iv()[3],
+                       uint32_t(counter), uint32_t(counter >> 32), length, flags};
+        auto g = [&](int a, int b, int c, int d, uint32_t x, uint32_t y) {
+            s[a] += s[b] + x; s[d] = rotr32(s[d] ^ s[a], 16);
+            s[c] += s[d]; s[b] = rotr32(s[b] ^ s[c], 12);
+            s[a] += s[b] + y; s[d] = rotr32(s[d] ^ s[a], 8);
+            s[c] += s[d]; s[b] = rotr32(s[b] ^ s[c], 7);
+        };
+        for (int round = 0; round < 7; ++round) {
+            const int* o{SCHEDULE[round]};
+            g(0, 4, 8, 12, m[o[0]], m[o[1]]); g(1, 5, 9, 13, m[o[2]], m[o[3]]); g(2, 6, 10, 14, m[o[4]], m[o[5]]); g(3, 7, 11, 15, m[o[6]], m[o[7]]);
+            g(0, 5, 10, 15, m[o[8]], m[o[9]]); g(1, 6, 11, 12, m[o[10]], m[o[11]]); g(2, 7, 8, 13, m[o[12]], m[o[13]]); g(3, 4, 9, 14, m[o[14]], m[o[15]]);
+        }
+        for (int i = 0; i < 8; ++i) { out[i] = s[i] ^ s[i + 8]; out[i + 8] = s[i + 8] ^ in[i]; }
+    }
+
+    // Compresses LANES whole chunks starting at data (chunk indices chunkCounter...) into their chaining values
+    void compressChunks(const unsigned char* data, uint32_t cvs[LANES][8]) {
+        uint32_t h[8][LANES]; // Chaining values, word-major so each step works on all lanes
+        for (int i = 0; i < 8; ++i) { for (int l = 0; l < LANES; ++l) { h[i][l] = iv()[i]; } }
+        for (size_t b = 0; b < CHUNK_LEN / 64; ++b) {
+            uint32_t m[16][LANES], s[16][LANES];
+            uint32_t flags{(b == 0 ? CHUNK_START : 0) | (b == CHUNK_LEN / 64 - 1 ? CHUNK_END : 0)};
+            for (int l = 0; l < LANES; ++l) {
+                const unsigned char* p{data + l * CHUNK_LEN + b * 64};
+                for (int i = 0; i < 16; ++i) { m[i][l] = load32(p + i * 4); }
+                uint64_t counter{chunkCounter + static_cast<uint64_t>(l)};
+                s[12][l] = uint32_t(counter); s[13][l] = uint32_t(counter >> 32);
+            }
+            for (int l = 0; l < LANES; ++l) {
+                for (int i = 0; i < 8; ++i) { s[i][l] = h[i][l]; }
+                for (int i = 0; i < 4; ++i) { s[8 + i][l] = iv()[i]; }
+                s[14][l] = 64; s[15][l] = flags;
+            }
+            auto g = [&](int a, int bb, int c, int d, int x, int y) {
+                for (int l = 0; l < LANES; ++l) {
+                    s[a][l] += s[bb][l] + m[x][l]; s[d][l] = rotr32(s[d][l] ^ s[a][l], 16);
+                    s[c][l] += s[d][l]; s[bb][l] = rotr32(s[bb][l] ^ s[c][l], 12);
+                    s[a][l] += s[bb][l] + m[y][l]; s[d][l] = rotr32(s[d][l] ^ s[a][l], 8);
+                    s[c][l] += s[d][l]; s[bb][l] = rotr32(s[bb][l] ^ s[c][l], 7);
+                }
+            };
+            for (int round = 0; round < 7; ++round) {
+                const int* o{SCHEDULE[round]};
+                g(0, 4, 8, 12, o[0], o[1]); g(1, 5, 9, 13, o[2], o[3]); g(2, 6, 10, 14, o[4], o[5]); g(3, 7, 11, 15, o[6], o[7]);
+                g(0, 5, 10, 15, o[8], o[9]); g(1, 6, 11, 12, o[10], o[11]); g(2, 7, 8, 13, o[12], o[13]); g(3, 4, 9, 14, o[14], o[15]);
+            }
+            for (int i = 0; i < 8; ++i) { for (int l = 0; l < LANES; ++l) { h[i][l] = s[i][l] ^ s[i + 8][l]; } }
+        }
+        for (int l = 0; l < LANES; ++l) { for (int i = 0; i < 8; ++i) { cvs[l][i] = h[i][l]; } }
+    }
+
+    void pushChunk(const uint32_t chunkCv[8]) { // Merges completed subtrees (one merge per trailing zero bit of the chunk count)
+        uint32_t merged[8];
+        std::memcpy(merged, chunkCv, sizeof(merged));
+        uint64_t total{++chunkCounter};
+        while ((total & 1) == 0) {
+            uint32_t m[16], out[16];
+            std::memcpy(m, cvStack[--stackLen], 32);
+            std::memcpy(m + 8, merged, 32);
+            compress(iv(), m, 0, 64, PARENT, out);
+            std::memcpy(merged, out, sizeof(merged));
+            total >>= 1;
+        }
+        std::memcpy(cvStack[stackLen++], merged, sizeof(merged));
+    }
 
-// Secure random data generation class
-class secureRandom {
-public:
-    secureRandom() = default;
+    void compressBlock(uint32_t flags) { // Compresses the buffered (full) block into the chunk's chaining value
+        uint32_t m[16], out[16];
+        for (int i = 0; i < 16; ++i) { m[i] = load32(block + i * 4); }
+        compress(cv, m, chunkCounter, 64, flags | (blocksCompressed == 0 ? CHUNK_START : 0), out);
+        std::memcpy(cv, out, sizeof(cv));
+        ++blocksCompressed;
+        blockLen = 0;
+    }
 
-    std::vector<unsigned char> generate(size_t size) {
-        std::vector<unsigned char> buffer(size);
+    void startChunk() {
+        std::memcpy(cv, iv(), sizeof(cv));
+        blockLen = 0;
+        blocksCompressed = 0;
+    }
 
-#ifdef _WIN32
-        NTSTATUS status = BCryptGenRandom(
-            NULL,                           // Use default RNG algorithm
-            buffer.data(),                  // Destination buffer
-            static_cast<ULONG>(size),       // Buffer size
-            BCRYPT_USE_SYSTEM_PREFERRED_RNG // Use system RNG
-        );
-        if (status != STATUS_SUCCESS) {
-            throw std::runtime_error("BCryptGenRandom failed to generate secure random data. Attempting fallback " + std::string(isOpenSSL ? "OpenSSL RAND_BYTES..." : "Mersenne Twister..."));
-        }
-#else
-        std::ifstream urandom("/dev/urandom", std::ios::in | std::ios::binary);
-        if (!urandom) {
-            throw std::runtime_error("Failed to open /dev/urandom for secure random data generation. Attempting fallback " + std::string(isOpenSSL ? "OpenSSL RAND_BYTES..." : "Mersenne Twister..."));
+public:
+    void reset() {
+        stackLen = 0;
+        chunkCounter = 0;
+        startChunk();
+    }
+
+    void update(const unsigned char* data, size_t size) {
+        while (size > 0) {
+            size_t chunkFill{blocksCompressed * 64 + blockLen};
+            if (chunkFill == CHUNK_LEN) { // More input follows, so the full chunk is not the root
+                compressBlock(CHUNK_END);
+                pushChunk(cv);
+                startChunk();
+                chunkFill = 0;
+            }
+            if (chunkFill == 0 && size > LANES * CHUNK_LEN) { // Whole chunks with input left over: LANES at a time
+                uint32_t cvs[LANES][8];
+                compressChunks(data, cvs);
+                uint64_t first{chunkCounter};
+                for (int l = 0; l < LANES; ++l) { chunkCounter = first + static_cast<uint64_t>(l); pushChunk(cvs[l]); }
+                data += LANES * CHUNK_LEN; size -= LANES * CHUNK_LEN;
+                continue;
+            }
+            if (blockLen == 64) { compressBlock(0); } // Only compressed once more input arrives (the last block gets CHUNK_END)
+            size_t take{std::min({size, sizeof(block) - blockLen, CHUNK_LEN - chunkFill})};
+            std::memcpy(block + blockLen, data, take);
+            blockLen += take; data += take; size -= take;
         }
-        urandom.read(reinterpret_cast<char*>(buffer.data()), size);
-        if (!urandom) {
-            throw std::runtime_error("Failed to read random data from /dev/urandom. Attempting fallback " + std::string(isOpenSSL ? "OpenSSL RAND_BYTES..." : "Mersenne Twister..."));
+    }
+
+    std::vector<unsigned char> finish() {
+        uint32_t m[16]{}, out[16], nodeCv[8];
+        unsigned char last[64]{};
+        std::memcpy(last, block, blockLen);
+        for (int i = 0; i < 16; ++i) { m[i] = load32(last + i * 4); }
+        uint32_t flags{CHUNK_END | (blocksCompressed == 0 ? CHUNK_START : 0)};
+        std::memcpy(nodeCv, cv, sizeof(nodeCv));
+        uint64_t counter{chunkCounter};
+        uint32_t length{static_cast<uint32_t>(blockLen)};
+        for (size_t parent = stackLen; parent > 0; --parent) { // Folds the stack from the right, each parent over the node below it
+            compress(nodeCv, m, counter, length, flags, out);
+            std::memcpy(m, cvStack[parent - 1], 32);
+            std::memcpy(m + 8, out, 32);
+            std::memcpy(nodeCv, iv(), sizeof(nodeCv));
+            counter = 0; length = 64; flags = PARENT;
         }
-#endif
-        return buffer;
+        compress(nodeCv, m, counter, length, flags | ROOT, out);
+        std::vector<unsigned char> digest(32);
+        for (int i = 0; i < 32; ++i) { digest[i] = static_cast<unsigned char>(out[i / 4] >> ((i % 4) * 8)); }
+        return digest;
     }
 };
 
-#ifndef OPENSSL_FOUND
-class randomizer {
+// XXH64 (non-cryptographic, for integrity checks where nobody chooses the data adversarially)
+class xxh64Hasher {
 private:
-    std::random_device rd;
-    std::mt19937 gen;
-    std::chrono::steady_clock::time_point lastSeedTime;
+    static constexpr uint64_t P1{11400714785074694791ULL}, P2{14029467366897019727ULL}, P3{1609587929392839161ULL}, P4{9650029242287828579ULL}, P5{2870177450012600261ULL};
+    uint64_t v[4]{}; // Accumulators for 32-byte stripes
+    unsigned char stripe[32]{}; // Buffered partial stripe
+    size_t stripeLen{};
+    uint64_t totalLen{};
+
+    static uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t load64(const unsigned char* p) { // Little-endian load (compiles to a single move on x86/ARM)
+        return uint64_t(p[0]) | (uint64_t(p[1]) << 8) | (uint64_t(p[2]) << 16) | (uint64_t(p[3]) << 24) | (uint64_t(p[4]) << 32) | (uint64_t(p[5]) << 40) | (uint64_t(p[6]) << 48) | (uint64_t(p[7]) << 56);
+    }
+    static uint64_t round(uint64_t acc, uint64_t input) { return rotl64(acc + input * P2, 31) * P1; }
+    static uint64_t merge(uint64_t acc, uint64_t value) { return (acc ^ round(0, value)) * P1 + P4; }
 
-    void reseedIfNecessary() {
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastSeedTime).count() >= 3) {
-            gen.seed(rd());
-            lastSeedTime = now;
-        }
+    void consume(const unsigned char* p) {
+        for (int i = 0; i < 4; ++i) { v[i] = round(v[i], load64(p + i * 8)); }
     }
 
 public:
-    randomizer() : gen(rd()), lastSeedTime(std::chrono::steady_clock::now()) {}
+    void reset() {
+        v[0] = P1 + P2; v[1] = P2; v[2] = 0; v[3] = 0 - P1; // Seed 0
+        stripeLen = 0;
+        totalLen = 0;
+    }
 
-    std::mt19937& getGenerator() {
-        reseedIfNecessary();
-        return gen;
+    void update(const unsigned char* data, size_t size) {
+        totalLen += size;
+        if (stripeLen > 0) {
+            size_t take{std::min(size, sizeof(stripe) - stripeLen)};
+            std::memcpy(stripe + stripeLen, data, take);
+            stripeLen += take; data += take; size -= take;
+            if (stripeLen < sizeof(stripe)) { return; }
+            consume(stripe);
+            stripeLen = 0;
+        }
+        for (; size >= 32; data += 32, size -= 32) { consume(data); }
+        std::memcpy(stripe, data, size);
+        stripeLen = size;
     }
 
-    std::random_device& getDevice() {
-        return rd;
+    std::vector<unsigned char> finish() {
+        uint64_t h{totalLen >= 32 ? rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18) : P5};
+        if (totalLen >= 32) { for (int i = 0; i < 4; ++i) { h = merge(h, v[i]); } }
+        h += totalLen;
+        size_t pos{};
+        for (; pos + 8 <= stripeLen; pos += 8) { h = rotl64(h ^ round(0, load64(stripe + pos)), 27) * P1 + P4; }
+        if (pos + 4 <= stripeLen) {
+            uint32_t word{uint32_t(stripe[pos]) | (uint32_t(stripe[pos + 1]) << 8) | (uint32_t(stripe[pos + 2]) << 16) | (uint32_t(stripe[pos + 3]) << 24)};
+            h = rotl64(h ^ (uint64_t(word) * P1), 23) * P2 + P3;
+            pos += 4;
+        }
+        for (; pos < stripeLen; ++pos) { h = rotl64(h ^ (stripe[pos] * P5), 11) * P1; }
+        h ^= h >> 33; h *= P2; h ^= h >> 29; h *= P3; h ^= h >> 32;
+        std::vector<unsigned char> digest(8);
+        for (int i = 0; i < 8; ++i) { digest[i] = static_cast<unsigned char>(h >> (56 - i * 8)); } // Canonical (big-endian) form
+        return digest;
     }
 };
+
+// Incremental digest of the data written by a pass (SHA-256 through EVP with OpenSSL, which uses SHA-NI/ARMv8 SHA where the
+// CPU has it, and the built-in implementations otherwise); only raw digest bytes are produced and compared
+class streamDigest {
+private:
+    hashAlgo algorithm;
+#ifdef OPENSSL_FOUND
+    EVP_MD_CTX* mdctx{nullptr}; // EVP digest context (SHA-256 only)
 #endif
+    sha256Portable sha256;
+    blake3Hasher blake3;
+    xxh64Hasher xxh64;
+
+public:
+    explicit streamDigest(hashAlgo alg = HASH_DEFAULT) : algorithm(alg) { reset(); }
+    ~streamDigest() {
 #ifdef OPENSSL_FOUND
-class secureRandomizer {
-private:
-    std::chrono::steady_clock::time_point lastSeedTime;
+        if (mdctx) { EVP_MD_CTX_free(mdctx); }
+#endif
+    }
+    streamDigest(const streamDigest&) = delete;
+    streamDigest& operator=(const streamDigest&) = delete;
 
-    // Generate cryptographically secure random bytes
-    std::vector<unsigned char> generateRandomBytes(size_t size) {
-        std::vector<unsigned char> buffer(size);
-        if (RAND_bytes(buffer.data(), static_cast<int>(size)) != 1) {
-            throw std::runtime_error("Failed to generate secure random bytes using OpenSSL RAND_bytes.");
+    void reset() {
+        switch (algorithm) {
+            case HASH_SHA256:
+#ifdef OPENSSL_FOUND
+                if (!mdctx) { mdctx = EVP_MD_CTX_new(); }
+                if (!mdctx || EVP_DigestInit_ex(mdctx, EVP_sha256(), nullptr) != 1) { throw std::runtime_error("Failed to initialize OpenSSL SHA256 context."); }
+#else
+                sha256.reset();
+#endif
+                break;
+            case HASH_BLAKE3: blake3.reset(); break;
+            case HASH_XXH64: xxh64.reset(); break;
         }
-        return buffer;
     }
 
-public:
-    secureRandomizer() : lastSeedTime(std::chrono::steady_clock::now()) {}
+    void update(const unsigned char* data, size_t size) {
+        phaseTimer timer(PHASE_HASH, size);
+        switch (algorithm) {
+            case HASH_SHA256:
+#ifdef OPENSSL_FOUND
+                if (EVP_DigestUpdate(mdctx, data, size) != 1) { throw std::runtime_error("Failed to update OpenSSL SHA256 context."); }
+#else
+                sha256.update(data, size);
+#endif
+                break;
+            case HASH_BLAKE3: blake3.update(data, size); break;
+            case HASH_XXH64: xxh64.update(data, size); break;
+        }
+    }
 
-    // Re-seeding isn't explicitly needed with OpenSSL RAND_bytes, but this function is desirable in case this implementation fails
-    std::vector<unsigned char> reseedIfNecessary(const size_t& size) {
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastSeedTime).count() >= 3) {
-            // OpenSSL automatically handles reseeding of its entropy pool.
-            lastSeedTime = now;
+    // Returns the raw digest bytes (the context must be reset before reuse)
+    std::vector<unsigned char> finish() {
+        switch (algorithm) {
+            case HASH_SHA256: {
+#ifdef OPENSSL_FOUND
+                unsigned char hash[EVP_MAX_MD_SIZE]{}; // Buffer for hash
+                unsigned int hashLen{}; // Length for hash
+                if (EVP_DigestFinal_ex(mdctx, hash, &hashLen) != 1) { throw std::runtime_error("Failed to finalize OpenSSL SHA256 hash."); }
+                return std::vector<unsigned char>(hash, hash + hashLen);
+#else
+                return sha256.finish();
+#endif
+            }
+            case HASH_BLAKE3: return blake3.finish();
+            case HASH_XXH64: return xxh64.finish();
         }
-        return generateRandomBytes(size);
+        return {};
     }
 };
-#endif
 
 // Declares structures in global scope so all functions reference the same structure
 config Config;
-wPerm wc;
-internal ic;
+thread_local wPerm wc; // Per-job permission state (each worker shreds one file at a time)
+thread_local internal ic; // Per-job internal print state
 pgrm Program;
+entropySource Entropy; // Random data source shared by every shred
 
-std::mutex fileMutex; // Defines file name generation lock
-
-auto lastSeedTime = std::chrono::steady_clock::now(); // Get current seed time
+std::mutex dirSyncMutex; // Guards the set of directories awaiting a sync
+std::unordered_set<std::string> pendingDirSyncs; // Parent directories of unlinked files (synced once per batch, not per file)
 
 enum logLevel { // Define valid log levels
     INFO, // Level to inform with verbosity (i.e., every action)
@@ -317,47 +1561,523 @@ enum logLevel { // Define valid log levels
     INTERNAL // Only used with '--internal' flag
 };
 
+// Asynchronous logger: any thread pushes entries into a lock-free ring; one writer thread formats, writes, and flushes them in batches
+class asyncLogger {
+private:
+    struct entry {
+        logLevel level{INFO};
+        int target{0}; // 0 = log line, 1 = raw text for standard output, 2 = raw text for standard error
+        int thread{0}; // Small per-thread number (log file only)
+        std::chrono::system_clock::time_point time{};
+        std::string text; // Message (or raw text, written as is)
+    };
+    struct slot {
+        std::atomic<size_t> sequence{0}; // Position this slot is ready for (bounded MPMC ring with per-slot sequence numbers)
+        entry item;
+    };
+    static constexpr size_t CAPACITY{4096}; // Entries in flight (power of two); producers wait rather than drop when it fills up
+
+    std::unique_ptr<slot[]> ring;
+    std::atomic<size_t> head{0}; // Next position a producer claims
+    size_t tail{0}; // Next position the writer reads (writer thread only)
+    std::atomic<size_t> written{0}; // Entries the writer has finished with
+    std::atomic<bool> active{false}; // Writer thread started
+    std::atomic<bool> waiting{false}; // Writer is parked on 'wake'
+    std::atomic<bool> stopping{false};
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    std::once_flag started;
+    std::thread writer;
+    std::ofstream logFile; // Structured log (JSON lines)
+
+    static int threadNumber() {
+        static std::atomic<int> next{0};
+        thread_local int number{++next};
+        return number;
+    }
+
+    static const char* levelName(logLevel type) { // To print the actual word rather than the numerical representation.
+        switch (type) {
+            case INFO: return "INFO";
+            case WARNING: return "WARNING";
+            case ERROR: return "ERROR";
+            case DRY_RUN: return "DRY_RUN";
+            case INTERNAL: return "INTERNAL";
+        }
+        return "INFO";
+    }
+
+    static std::string jsonEscape(const std::string& text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') { escaped += '\\'; escaped += static_cast<char>(c); }
+            else if (c < 0x20) { char code[8]; std::snprintf(code, sizeof(code), "\\u%04x", c); escaped += code; }
+            else { escaped += static_cast<char>(c); }
+        }
+        return escaped;
+    }
+
+    void push(entry&& item) {
+        std::call_once(started, [this]() { writer = std::thread(&asyncLogger::run, this); active = true; }); // Started on first use (not for --help)
+        size_t position{head.load(std::memory_order_relaxed)};
+        slot* target{nullptr};
+        while (true) {
+            target = &ring[position & (CAPACITY - 1)];
+            std::intptr_t diff{static_cast<std::intptr_t>(target->sequence.load(std::memory_order_acquire)) - static_cast<std::intptr_t>(position)};
+            if (diff == 0 && head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; } // Claimed
+            if (diff < 0) { std::this_thread::yield(); position = head.load(std::memory_order_relaxed); } // Full: wait for the writer
+                else if (diff > 0) { position = head.load(std::memory_order_relaxed); } // Another producer took it
+        }
+        target->item = std::move(item);
+        target->sequence.store(position + 1, std::memory_order_release); // Publishes the entry
+        if (waiting.load(std::memory_order_acquire)) { wake.notify_one(); }
+    }
+
+    bool ready() const { return ring[tail & (CAPACITY - 1)].sequence.load(std::memory_order_acquire) == tail + 1; }
+
+    void write(const entry& item) {
+        if (item.target == 1) { std::cout << item.text; return; }
+        if (item.target == 2) { std::cerr << item.text; return; }
+        std::time_t time{std::chrono::system_clock::to_time_t(item.time)};
+        std::tm tm{*std::localtime(&time)}; // Only this thread calls localtime()
+        if (Config.isVerbose() || Config.isInternal() || item.level != INFO) { // Only print WARNING, ERRORS, or DRY_RUN levels (unless verbose)
+            std::cout << "[" << std::put_time(&tm, "%m-%d-%Y %H:%M:%S") << "] [" << levelName(item.level) << "] " << item.text << '\n'; // logs in format: [MM-DD-YY] [LEVEL] MESSAGE
+        }
+        if (logFile.is_open()) {
+            auto millis{std::chrono::duration_cast<std::chrono::milliseconds>(item.time.time_since_epoch()).count() % 1000};
+            logFile << "{\"time\": \"" << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S") << '.' << std::setfill('0') << std::setw(3) << millis << std::setfill(' ')
+                    << "\", \"level\": \"" << levelName(item.level) << "\", \"thread\": " << item.thread << ", \"message\": \"" << jsonEscape(item.text) << "\"}\n";
+        }
+    }
+
+    void run() {
+        while (true) {
+            bool wrote{false};
+            while (ready()) {
+                slot& current{ring[tail & (CAPACITY - 1)]};
+                entry item{std::move(current.item)};
+                current.sequence.store(tail + CAPACITY, std::memory_order_release); // Frees the slot for the next lap
+                ++tail;
+                write(item);
+                written.fetch_add(1, std::memory_order_release);
+                wrote = true;
+            }
+            if (wrote) { // One flush per batch instead of one per line
+                std::cout.flush();
+                std::cerr.flush();
+                if (logFile.is_open()) { logFile.flush(); }
+            }
+            if (stopping.load(std::memory_order_acquire) && !ready()) { return; }
+            std::unique_lock<std::mutex> guard(wakeLock);
+            waiting = true;
+            wake.wait_for(guard, std::chrono::milliseconds(10), [&]() { return ready() || stopping.load(); }); // Timed, so a missed notify only delays a line
+            waiting = false;
+        }
+    }
+
+public:
+    asyncLogger() : ring(new slot[CAPACITY]) {
+        for (size_t i = 0; i < CAPACITY; ++i) { ring[i].sequence.store(i, std::memory_order_relaxed); }
+    }
+    ~asyncLogger() { // Drains everything still queued (also runs on exit())
+        if (!active) { return; }
+        stopping = true;
+        wake.notify_one();
+        writer.join();
+    }
+    asyncLogger(const asyncLogger&) = delete;
+    asyncLogger& operator=(const asyncLogger&) = delete;
+
+    bool openLogFile(const std::string& path) {
+        logFile.open(path, std::ios::app);
+        return logFile.is_open();
+    }
+
+    void log(logLevel type, const std::string& message) { // Timestamped here, formatted by the writer
+        push(entry{type, 0, threadNumber(), std::chrono::system_clock::now(), message});
+    }
+
+    void raw(std::string text, bool toStderr = false) { // Unformatted console output kept in order with the log lines
+        push(entry{INFO, toStderr ? 2 : 1, 0, {}, std::move(text)});
+    }
+
+    void flush() { // Blocks until everything queued so far has been written (before printing to the console directly)
+        if (!active) { return; }
+        size_t target{head.load(std::memory_order_acquire)};
+        while (written.load(std::memory_order_acquire) < target) {
+            wake.notify_one();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+};
+
+asyncLogger Logger; // Declared after Config so it is destroyed (and drained) before it
+
 // Prototype declarations for refactoring
-#ifdef OPENSSL_FOUND // Only declares these prototypes if compiling with OpenSSL (since it would be required)
-    int verifyWithHash(const std::string& filePath, const std::vector<unsigned char>& expectedData, const int& pass);
-    std::string computeSHA256(const std::vector<unsigned char>& data);
+int verifyWithHash(const std::string& filePath, rawFile& file, const std::vector<std::vector<extent>>& ranges, std::uintmax_t bufferSize, const std::vector<unsigned char>& expectedDigest, const int& pass);
+int verifyWithKeystream(const std::string& filePath, rawFile& file, const std::vector<extent>& extents, pooledBuffer& verifyBuffer, const keystreamSeed& finalSeed, const int& pass);
+#ifdef OPENSSL_FOUND // The verification status is only tracked for OpenSSL builds
     struct hashStat {
     private:
-        friend int verifyWithHash(const std::string& filePath, const std::vector<unsigned char>& expectedData, const int& pass);
+        friend int verifyWithHash(const std::string& filePath, rawFile& file, const std::vector<std::vector<extent>>& ranges, std::uintmax_t bufferSize, const std::vector<unsigned char>& expectedDigest, const int& pass);
         bool isVerified{false};
         void updateVerification(bool value){isVerified = value;}
     public:
         bool Verified(){return isVerified;}
     };
-    hashStat hash;
+    thread_local hashStat hash;
 #endif
 
 void help(char* argv[]);
 void shortHelp(char* argv[]);
+void runBenchmark();
+int preallocateFile(const fs::path& path, std::uintmax_t size);
+std::uintmax_t writeTailFile(const fs::path& path);
+void wipeFreeSpace(const fs::path& mount);
 void copyright(char* argv[]);
 void version(char* argv[]);
 
-int overwriteWithRandomData(std::string filePath, std::fstream& file, std::uintmax_t fileSize, int pass = 1);
+int overwriteWithRandomData(std::string filePath, rawFile& file, std::uintmax_t fileSize, std::uintmax_t bufferSize, int threads = 1, int pass = 1, size_t resumeSweep = 0, std::uintmax_t watermark = 0, const std::string* journalKey = nullptr);
+std::vector<std::vector<extent>> splitRanges(const std::vector<extent>& map, std::uintmax_t blockSize, int threads);
+bool forEachBlock(const std::vector<extent>& extents, std::uintmax_t blockSize, const std::function<bool(std::uintmax_t, size_t)>& visit);
+std::vector<extent> extentsFrom(const std::vector<extent>& extents, std::uintmax_t offset);
+std::vector<extent> allocatedExtents(rawFile& file, std::uintmax_t fileSize);
+bool runParallel(size_t count, const std::function<void(size_t)>& work);
+std::vector<unsigned char> combineDigests(const std::vector<std::vector<unsigned char>>& digests);
 
-bool shredFile(const fs::path& filePath);
+bool shredFile(const fs::path& filePath, fileInfo info = fileInfo{});
 bool changePermissions(const std::string &filePath);
-int hasWritePermission(const fs::path& path);
+int hasWritePermission(const fs::path& path, const fileInfo& info);
+bool statFile(const fs::path& path, fileInfo& info);
+void dispatchFile(const fs::path& path, const fileInfo& info);
+#ifndef _WIN32
+void walkDirectory(const fs::path& root);
+#endif
 
 
 void processPath(const fs::path& path);
-void syncFile(const fs::path& filePath);
+void processManifest(const std::string& source);
 void logMessage(logLevel type, const std::string& message);
+bool isLogged(logLevel type);
 void errorExit(int value = 1, std::string message = "", std::string flag = "", bool customLogger = false);
-void cleanupMetadata(std::string& filePath);
+void cleanupMetadata(rawFile& file);
+bool unlinkObfuscated(const fs::path& filePath);
+void syncDirectories();
 
 std::vector<std::string> parseArguments(int argc, char* argv[]);
-std::uintmax_t getOptimalBlockSize();
+ioGeometry getOptimalBlockSize(const fs::path& filePath, const fileInfo& info);
+bool parseSize(const std::string& text, std::uintmax_t& value);
 std::string generateRandomFileName(size_t length = 32);
 
+bool isRotationalDevice(std::uintmax_t device);
+
 bool isRegularFile(const fs::path& file) { return fs::is_regular_file(file); } // Function to check if a path is a regular file
 
+// Bounded worker pool for shredding independent files concurrently (-j), limited per backing device
+class shredPool {
+private:
+    struct job {
+        fs::path path; // File to shred
+        fileInfo info; // Metadata from the traversal (device is used for the per-device limit)
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<job> queue; // Pending files (bounded by capacity)
+    std::unordered_map<std::uintmax_t, int> active; // Running jobs per device
+    std::unordered_map<std::uintmax_t, int> limits; // Concurrency limit per device (looked up once)
+    std::mutex lock;
+    std::condition_variable workReady; // A job was queued or a device slot freed
+    std::condition_variable spaceReady; // The queue has room
+    std::condition_variable idle; // Queue is empty and no job is running
+    size_t capacity;
+    int running{0};
+    bool stopping{false};
+
+    int deviceLimit(std::uintmax_t device) { // Called with the lock held
+        auto found{limits.find(device)};
+        if (found != limits.end()) { return found->second; }
+        int limit{Config.getDeviceJobs() > 0 ? Config.getDeviceJobs() : (isRotationalDevice(device) ? 1 : Config.getJobs())}; // Seeks dominate on spinning disks
+        limits.emplace(device, limit);
+        return limit;
+    }
+
+    void worker() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            auto next{queue.end()};
+            workReady.wait(guard, [&]() {
+                next = std::find_if(queue.begin(), queue.end(), [&](const job& j) { return active[j.info.device] < deviceLimit(j.info.device); }); // First job whose device has a free slot
+                return next != queue.end() || (stopping && queue.empty());
+            });
+            if (next == queue.end()) { return; } // Stopping with nothing left to do
+
+            job current{std::move(*next)};
+            queue.erase(next);
+            ++active[current.info.device];
+            ++running;
+            spaceReady.notify_one();
+            guard.unlock();
+
+            shredFile(current.path, current.info); // Records its own errors in Program
+
+            guard.lock();
+            --active[current.info.device];
+            --running;
+            workReady.notify_all(); // A device slot is free again
+            if (queue.empty() && running == 0) { idle.notify_all(); }
+        }
+    }
+
+public:
+    explicit shredPool(int jobs) : capacity(static_cast<size_t>(jobs) * 4) {
+        for (int n = 0; n < jobs; ++n) { workers.emplace_back(&shredPool::worker, this); }
+    }
+
+    ~shredPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        workReady.notify_all();
+        for (auto& thread : workers) { thread.join(); }
+    }
+
+    shredPool(const shredPool&) = delete;
+    shredPool& operator=(const shredPool&) = delete;
+
+    void submit(const fs::path& path, fileInfo info) { // Queues a file, blocking while the queue is full
+        if (!info.known) { statFile(path, info); } // Top-level arguments arrive without metadata
+        std::unique_lock<std::mutex> guard(lock);
+        spaceReady.wait(guard, [&]() { return queue.size() < capacity; });
+        queue.push_back(job{path, info});
+        workReady.notify_all();
+    }
+
+    void wait() { // Blocks until every queued file has been shredded
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [&]() { return queue.empty() && running == 0; });
+    }
+};
+
+std::unique_ptr<shredPool> Pool; // Worker pool (only when '-j' is above 1)
+
+// Prints the running write rate every 2 seconds while --stats is on (stopped and joined on destruction)
+class statsReporter {
+private:
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping{false};
+    std::thread thread; // Declared last so it starts after the members it waits on
+
+    void run() {
+        auto last{std::chrono::steady_clock::now()};
+        std::uint64_t lastBytes{Stats.bytesWritten()};
+        std::unique_lock<std::mutex> guard(lock);
+        while (!wake.wait_for(guard, std::chrono::seconds(2), [&]() { return stopping; })) {
+            auto now{std::chrono::steady_clock::now()};
+            std::uint64_t bytes{Stats.bytesWritten()};
+            double seconds{std::chrono::duration<double>(now - last).count()};
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(1) << "[STATS] " << bytes / 1048576.0 << " MiB written, " << (seconds > 0 ? ((bytes - lastBytes) / 1048576.0) / seconds : 0.0)
+                 << " MiB/s, " << Stats.filesDone() << " files";
+            line << '\n';
+            Logger.raw(line.str(), true);
+            last = now;
+            lastBytes = bytes;
+        }
+    }
+
+public:
+    statsReporter() : thread(&statsReporter::run, this) {}
+    ~statsReporter() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+    statsReporter(const statsReporter&) = delete;
+    statsReporter& operator=(const statsReporter&) = delete;
+};
+
+// Append-only record of finished work for --journal/--resume: files that are done, and for large files the last
+// completed pass/sweep plus the offset below which the current sweep is on the media. Records are NUL-terminated
+// (paths may contain anything else) and written in batches, so a sync is paid about once a second, not per file
+class shredJournal {
+public:
+    struct mark { // Passes before 'pass' and sweeps before 'sweep' are complete; sweep 'sweep' is complete below 'watermark'
+        int pass{};
+        size_t sweep{};
+        std::uintmax_t watermark{};
+    };
+    static constexpr std::uintmax_t TRACKED_SIZE{64ULL * 1024 * 1024}; // Files at least this large get pass and watermark records
+    static constexpr std::uintmax_t CHECKPOINT_BYTES{1024ULL * 1024 * 1024}; // Bytes written between watermark records
+
+private:
+    static constexpr size_t BATCH_RECORDS{512}; // Pending records that force a flush
+    static constexpr std::chrono::milliseconds BATCH_AGE{1000}; // Oldest a pending record gets before the next append flushes it
+
+    struct entry { mark at; std::uintmax_t size; }; // Watermark plus the file size it was taken at
+    std::mutex lock;
+    std::FILE* out{nullptr};
+    std::string pending; // Records not yet written
+    size_t pendingRecords{};
+    std::chrono::steady_clock::time_point lastFlush{};
+    fs::path base; // Working directory at open (keys are absolute, so relative arguments match across runs)
+    std::unordered_set<std::string> done; // Loaded by --resume (read-only afterwards, so lookups need no lock)
+    std::unordered_map<std::string, entry> marks; // Latest watermark of every unfinished large file
+
+    void flushLocked() {
+        if (!out || pending.empty()) { return; }
+        std::fwrite(pending.data(), 1, pending.size(), out);
+        std::fflush(out);
+#ifdef _WIN32
+        _commit(_fileno(out));
+#elif defined(__linux__)
+        fdatasync(fileno(out));
+#else
+        fsync(fileno(out));
+#endif
+        pending.clear();
+        pendingRecords = 0;
+        lastFlush = std::chrono::steady_clock::now();
+    }
+
+    void append(const std::string& record, bool force) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!out) { return; }
+        pending += record;
+        pending += '\0';
+        if (force || ++pendingRecords >= BATCH_RECORDS || std::chrono::steady_clock::now() - lastFlush >= BATCH_AGE) { flushLocked(); }
+    }
+
+    std::uintmax_t load(const std::string& path) { // Replays an existing journal; returns the size of its complete records (a torn last record from a crash is ignored)
+        std::ifstream in(path, std::ios::binary);
+        std::string record;
+        std::uintmax_t complete{0}; // Byte after the last terminator
+        while (std::getline(in, record, '\0')) {
+            if (in.eof()) { break; } // No terminator: the record was cut off mid-write
+            complete += record.size() + 1;
+            if (record.size() > 2 && record.compare(0, 2, "D\t") == 0) {
+                std::string key{record.substr(2)};
+                done.insert(key);
+                marks.erase(key);
+            } else if (record.size() > 2 && record.compare(0, 2, "P\t") == 0) {
+                size_t fields[4]{}; // Positions of the tabs before size, pass, sweep and watermark (the path is the rest)
+                size_t at{1};
+                bool ok{true};
+                for (int field = 0; field < 4 && ok; ++field) { fields[field] = at; at = record.find('\t', at + 1); ok = at != std::string::npos; }
+                if (!ok) { continue; }
+                try {
+                    entry value{{std::stoi(record.substr(fields[1] + 1)), static_cast<size_t>(std::stoull(record.substr(fields[2] + 1))),
+                                 std::stoull(record.substr(fields[3] + 1))}, std::stoull(record.substr(fields[0] + 1))};
+                    marks[record.substr(at + 1)] = value;
+                } catch (...) { continue; } // Corrupt record
+            }
+        }
+        return complete;
+    }
+
+public:
+    shredJournal() = default;
+    ~shredJournal() {
+        std::lock_guard<std::mutex> guard(lock);
+        flushLocked();
+        if (out) { std::fclose(out); }
+    }
+    shredJournal(const shredJournal&) = delete;
+    shredJournal& operator=(const shredJournal&) = delete;
+
+    bool open(const std::string& path, bool resume) { // Loads and appends to the journal when resuming, starts a new one otherwise
+        std::error_code ec;
+        base = fs::current_path(ec);
+        if (resume) {
+            std::uintmax_t complete{load(path)};
+            std::uintmax_t size{fs::file_size(path, ec)};
+            if (!ec && size > complete) { // Cut a torn record off; terminating it instead would turn the fragment into a valid (wrong) record
+                fs::resize_file(path, complete, ec);
+                if (ec) { return false; }
+            }
+        }
+        out = std::fopen(path.c_str(), resume ? "ab" : "wb");
+        if (!out) { return false; }
+        lastFlush = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool isOpen() const {return out != nullptr;}
+    size_t doneCount() const {return done.size();}
+    size_t partialCount() const {return marks.size();}
+
+    std::string key(const fs::path& path) const { // Absolute, normalized path (how files are identified between runs)
+        return (path.is_absolute() ? path : base / path).lexically_normal().string();
+    }
+
+    bool isDone(const std::string& key) const { return done.count(key) != 0; }
+
+    bool resumePoint(const std::string& key, std::uintmax_t size, mark& at) const { // False if nothing is recorded or the file has changed size
+        auto it{marks.find(key)};
+        if (it == marks.end() || it->second.size != size) { return false; }
+        at = it->second.at;
+        return true;
+    }
+
+    void fileDone(const std::string& key) { append("D\t" + key, false); }
+
+    void checkpoint(const std::string& key, const mark& at, std::uintmax_t size, bool force) { // Only called once the marked data has been synchronized
+        append("P\t" + std::to_string(size) + "\t" + std::to_string(at.pass) + "\t" + std::to_string(at.sweep) + "\t" + std::to_string(at.watermark) + "\t" + key, force);
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> guard(lock);
+        flushLocked();
+    }
+};
+
+static bool checkTornJournal(const fs::path& directory) { // Known-answer test: --resume must drop a torn last record, not complete it
+    fs::path path{directory / ("shred-kat-" + generateRandomFileName(8))};
+    const std::string complete{std::string("D\t/kat/done") + '\0' + "P\t1048576\t1\t0\t4096\t/kat/big" + '\0'};
+    bool ok{true};
+    for (const std::string& torn : {std::string("D\t/kat/ab"), std::string("P\t1048576\t2\t0\t8192\t/kat/bi")}) { // Cut-off records for '/kat/abc' and '/kat/big2'
+        { std::ofstream out(path, std::ios::binary | std::ios::trunc); out << complete << torn; }
+        for (int run = 0; run < 2; ++run) { // Neither the first resume nor the one after it may see the fragment
+            shredJournal journal;
+            shredJournal::mark at;
+            if (!journal.open(path.string(), true) || !journal.isDone("/kat/done") || journal.isDone("/kat/ab") || journal.partialCount() != 1
+                || !journal.resumePoint("/kat/big", 1048576, at) || at.pass != 1 || at.watermark != 4096) { ok = false; }
+        }
+        std::error_code ec{};
+        if (fs::file_size(path, ec) != complete.size()) { ok = false; } // Truncated back to the last terminator
+    }
+    std::error_code ec{};
+    fs::remove(path, ec);
+    return ok;
+}
+
+shredJournal Journal; // Empty unless --journal is given
+
 int main(int argc, char* argv[]) {
     std::vector<std::string> fileArgs{parseArguments(argc, argv)}; // Initialize vector with arguments
+    if (!Config.getLogFile().empty() && !Logger.openLogFile(Config.getLogFile())) { errorExit(1, "Failed to open log file '" + Config.getLogFile() + "'"); }
+    if (Config.isSelf_test()) { // Known-answer checks of components that are hard to exercise from a normal run (file arguments are ignored)
+        bool journalOk{checkTornJournal(fs::temp_directory_path())};
+        std::cout << "Known-answer: torn journal record " << (journalOk ? "dropped (ok)" : "FAILED") << std::endl;
+        return journalOk ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (!Config.getJournal().empty() && !Config.isBenchmark() && !Config.isDry_run()) { // Dry runs and benchmarks do no work worth recording
+        if (!Journal.open(Config.getJournal(), Config.isResume())) { errorExit(1, "Failed to open journal '" + Config.getJournal() + "'"); }
+        if (Config.isResume()) { logMessage(INFO, "Resuming from journal '" + Config.getJournal() + "': " + std::to_string(Journal.doneCount()) + " files done, " + std::to_string(Journal.partialCount()) + " partially overwritten."); }
+    }
+    if (Config.isBenchmark()) { // Benchmark harness replaces the normal run (file arguments are ignored)
+        if (Config.isStats()) { Stats.enable(); }
+        auto benchStart{std::chrono::steady_clock::now()};
+        runBenchmark();
+        Logger.flush();
+        if (Config.isStats()) { std::cout << Stats.report(std::chrono::duration<double>(std::chrono::steady_clock::now() - benchStart).count(), false) << std::flush; } // Totals over every run
+        return Program.isError() ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
     if (Config.isInternal()) { // Funny extra feature for people in the know about this flag (outputs parameters, files, and a confirmation)
         // Sets flags to strings for readability
         std::string recursiveStr{Config.isRecursive() ? "true" : "false"};
@@ -367,11 +2087,14 @@ int main(int argc, char* argv[]) {
         std::string dry_runStr{Config.isDry_run() ? "true" : "false"};
         std::string verifyStr{Config.isVerify() ? "true" : "false"};
         std::string force_deleteStr{Config.isForce_delete() ? "true" : "false"};
+        std::string rngStr{Config.getRng() == RNG_KERNEL ? "kernel" : (Config.getRng() == RNG_CHACHA ? "chacha" : "aesctr")};
 
         // Prints set options
         std::cout << "Files: " << std::endl;
-        for (const auto& filePath : fileArgs) { std::cout << filePath << std::endl; } std::cout << std::endl; // Prints file names
-        std::cout << "Parameters ~ Overwrites: " << Config.getOverwriteCount() << ", Recursive: " << recursiveStr << ", Keep_files: " << keep_filesStr << ", Follow_symlinks: " << follow_symlinksStr << ", Secure_mode: " << secure_modeStr << ", Dry_run: " << dry_runStr << ", Verify: " << verifyStr << ", Force: " << force_deleteStr << std::endl << std::endl;
+        for (const auto& filePath : fileArgs) { std::cout << filePath << std::endl; } // Prints file names
+        if (!Config.getManifest().empty()) { std::cout << "(paths listed in '" << Config.getManifest() << "')" << std::endl; }
+        std::cout << std::endl;
+        std::cout << "Parameters ~ Overwrites: " << Config.getOverwriteCount() << ", Recursive: " << recursiveStr << ", Keep_files: " << keep_filesStr << ", Follow_symlinks: " << follow_symlinksStr << ", Secure_mode: " << secure_modeStr << ", Dry_run: " << dry_runStr << ", Verify: " << verifyStr << ", Force: " << force_deleteStr << ", RNG: " << rngStr << ", Hash: " << (Config.getHash() == HASH_SHA256 ? "sha256" : (Config.getHash() == HASH_BLAKE3 ? "blake3" : "xxh64")) << ", Block_size: " << (Config.getBlockSize() ? std::to_string(Config.getBlockSize()) : "auto") << ", Direct_io: " << (Config.isDirect_io() ? "true" : "false") << ", Jobs: " << Config.getJobs() << ", Device_jobs: " << (Config.getDeviceJobs() ? std::to_string(Config.getDeviceJobs()) : "auto") << ", File_threads: " << (Config.getFileThreads() ? std::to_string(Config.getFileThreads()) : "auto") << ", Queue_depth: " << Config.getQueueDepth() << ", Sparse: " << (Config.isSparse() ? "true" : "false") << ", Stats: " << (Config.isStats() ? (Config.getStatsFile().empty() ? "stdout" : Config.getStatsFile()) : "false") << ", Journal: " << (Config.getJournal().empty() ? "none" : Config.getJournal() + (Config.isResume() ? " (resume)" : "")) << ", Wipe_free_space: " << (Config.getWipeMount().empty() ? "none" : Config.getWipeMount()) << std::endl << std::endl;
 
         
         // Prompt to continue the script with the printed options / files
@@ -390,14 +2113,39 @@ int main(int argc, char* argv[]) {
 
     std::cout << "Beginning Shred at: " << std::put_time(&local_tm, "%H:%M:%S") << std::endl; // Prints start time to user terminal
 
+    std::unique_ptr<statsReporter> liveStats; // Live rate line (only under --stats)
+    if (Config.isStats()) { Stats.enable(); liveStats = std::make_unique<statsReporter>(); }
+    if (Config.getJobs() > 1) { Pool = std::make_unique<shredPool>(Config.getJobs()); } // Files are shredded concurrently
+
     for (const auto& filePath : fileArgs) { // Process each provided path (main function)
         processPath(filePath);
     }
+    if (!Config.getManifest().empty()) { processManifest(Config.getManifest()); } // Streamed after the command-line paths
+    if (!Config.getWipeMount().empty()) { wipeFreeSpace(Config.getWipeMount()); } // After the files, so the space they free is wiped too
+    Pool.reset(); // Waits for the remaining files and joins the workers
+    syncDirectories(); // Makes the unlinks durable
 
     auto endT{std::chrono::system_clock::now()}; // Gets end time (for printing at end)
     auto endTime{std::chrono::high_resolution_clock::now()}; // Retrieves time after program has completed
     std::chrono::duration<double> duration{endTime - startTime}; // Calculates total run time in seconds
 
+    if (Config.isStats()) { // Writes the report once every worker has finished
+        liveStats.reset();
+        Logger.flush();
+        const std::string& statsPath{Config.getStatsFile()};
+        bool csv{statsPath.size() > 4 && statsPath.compare(statsPath.size() - 4, 4, ".csv") == 0};
+        std::string report{Stats.report(duration.count(), csv)};
+        if (statsPath.empty()) {
+            std::cout << report << std::flush;
+        } else {
+            std::ofstream statsOut(statsPath, std::ios::trunc);
+            if (!(statsOut << report)) {
+                logMessage(ERROR, "Failed to write statistics to '" + statsPath + "'");
+                Program.updateErrorStatus();
+            }
+        }
+    }
+
     if (!Config.isRecursive()) { // Will print at the end (if verbose) [runtime statistics]
         logMessage(INFO, "File shredding process completed. " + std::to_string(duration.count()) + " seconds.");
     } else { // Specifies mode
@@ -407,6 +2155,8 @@ int main(int argc, char* argv[]) {
     std::time_t EndTime{std::chrono::system_clock::to_time_t(endT)}; // Converts end time to printable format
     std::tm localEndTime{*std::localtime(&EndTime)}; // Gets time in local timezone
 
+    Journal.flush(); // Last batch of records reaches the media before the run is reported complete
+    Logger.flush(); // Every queued line is printed before the summary
     std::cout << "Shred completed at: " << std::put_time(&localEndTime, "%H:%M:%S") << std::endl;
     
     if (Program.isError()) { return EXIT_FAILURE; }
@@ -417,8 +2167,22 @@ std::vector<std::string> parseArguments(int argc, char* argv[]) {
     std::vector<std::string> fileArgs; // Store file paths
     std::string nfMsg{"Flag '-n' requires a positive integer"};
     std::string nlMsg{"Flag '--number' requires a positive integer"};
+    std::string rngMsg{"Option '--rng' requires one of: kernel, chacha, aesctr"};
+    std::string hashMsg{"Option '--hash' requires one of: sha256, blake3, xxh64"};
+    std::string bsMsg{"Option '--block-size' requires a positive size (e.g., 1048576, 512K, 4M)"};
+    std::string jfMsg{"Flag '-j' requires a positive integer"};
+    std::string jlMsg{"Option '--jobs' requires a positive integer"};
+    std::string djMsg{"Option '--device-jobs' requires a positive integer"};
+    std::string ftMsg{"Option '--file-threads' requires a positive integer"};
+    std::string qdMsg{"Option '--queue-depth' requires a positive integer"};
+    std::string sfMsg{"Option '--stats-file' requires a path"};
+    std::string ffMsg{"Option '--from-file' requires a path"};
+    std::string lfMsg{"Option '--log-file' requires a path"};
+    std::string jnMsg{"Option '--journal' requires a path"};
+    std::string wfMsg{"Option '--wipe-free-space' requires a mount point"};
     
     int i{};
+    std::string longValue{}; // Value attached to a long option with '=' (e.g., --rng=chacha)
 
     // Define short flag handlers
     std::unordered_map<char, std::function<void(size_t&, const std::string&)>> shortFlagActions{
@@ -446,6 +2210,25 @@ std::vector<std::string> parseArguments(int argc, char* argv[]) {
                 errorExit(1, nfMsg);
             }
         }},
+        {'j', [&](size_t& j, const std::string& arg) {
+            size_t start{j + 1}, end{start};
+            while (end < arg.size() && std::isdigit(arg[end])) {
+                ++end;
+            }
+            int value{};
+            try {
+                if (start < end) { // Attached number (e.g., -j8)
+                    value = std::stoi(arg.substr(start, end - start));
+                    j = end - 1;
+                } else if (start == arg.size() && i + 1 < argc) { // Number in the next argument (e.g., -j 8)
+                    value = std::stoi(argv[++i]);
+                }
+            } catch (...) {
+                errorExit(1, jfMsg);
+            }
+            if (value < 1) { errorExit(1, jfMsg); }
+            Config.updateJobs(value);
+        }},
         {'r', [&](size_t&, const std::string&) { Config.updateFlag("recursive", true); }},
         {'k', [&](size_t&, const std::string&) { Config.updateFlag("keep_files", true); }},
         {'v', [&](size_t&, const std::string&) { Config.updateFlag("verbose", true); }},
@@ -477,8 +2260,100 @@ std::vector<std::string> parseArguments(int argc, char* argv[]) {
         {"no-verify", [&]() { Config.updateFlag("verify", false); }},
         {"force", [&]() { Config.updateFlag("force_delete", true); }},
         {"internal", [&]() { Config.updateFlag("internal", true); }},
+        {"buffered", [&]() { Config.updateFlag("direct_io", false); }},
+        {"stats", [&]() { Config.updateFlag("stats", true); }},
+        {"sparse", [&]() { Config.updateFlag("sparse", true); }},
+        {"from-stdin", [&]() { Config.updateManifest("-"); }},
+        {"log-file", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            if (value.empty()) { errorExit(1, lfMsg); }
+            Config.updateLogFile(value);
+        }},
+        {"journal", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            if (value.empty()) { errorExit(1, jnMsg); }
+            Config.updateJournal(value);
+        }},
+        {"resume", [&]() { Config.updateFlag("resume", true); }},
+        {"self-test", [&]() { Config.updateFlag("self_test", true); }},
+        {"wipe-free-space", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            if (value.empty()) { errorExit(1, wfMsg); }
+            Config.updateWipeMount(value);
+        }},
+        {"from-file", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            if (value.empty()) { errorExit(1, ffMsg); }
+            Config.updateManifest(value);
+        }},
+        {"benchmark", [&]() { Config.updateBenchmarkDir(longValue); }}, // Directory is optional, so only '--benchmark=DIR' sets it
+        {"stats-file", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            if (value.empty()) { errorExit(1, sfMsg); }
+            Config.updateStatsFile(value);
+        }},
         {"version", [&]() { version(argv); }},
         {"copyright", [&]() { copyright(argv); }},
+        {"rng", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            if (!Config.updateRng(value)) { errorExit(1, rngMsg); }
+        }},
+        {"hash", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            if (!Config.updateHash(value)) { errorExit(1, hashMsg); }
+        }},
+        {"jobs", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            int jobs{};
+            try { jobs = std::stoi(value); } catch (...) { errorExit(1, jlMsg); }
+            if (jobs < 1) { errorExit(1, jlMsg); }
+            Config.updateJobs(jobs);
+        }},
+        {"device-jobs", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            int jobs{};
+            try { jobs = std::stoi(value); } catch (...) { errorExit(1, djMsg); }
+            if (jobs < 1) { errorExit(1, djMsg); }
+            Config.updateDeviceJobs(jobs);
+        }},
+        {"file-threads", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            int threads{};
+            try { threads = std::stoi(value); } catch (...) { errorExit(1, ftMsg); }
+            if (threads < 1) { errorExit(1, ftMsg); }
+            Config.updateFileThreads(threads);
+        }},
+        {"queue-depth", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            int depth{};
+            try { depth = std::stoi(value); } catch (...) { errorExit(1, qdMsg); }
+            if (depth < 1) { errorExit(1, qdMsg); }
+            Config.updateQueueDepth(depth);
+        }},
+        {"block-size", [&]() {
+            std::string value{longValue};
+            if (value.empty() && ++i < argc) { value = argv[i]; }
+            std::uintmax_t size{};
+            if (!parseSize(value, size)) { errorExit(1, bsMsg); }
+            std::uintmax_t page{alignedBuffer::pageSize()};
+            if (size % page != 0) { // Unaligned transfers would make every direct I/O block fall back to buffered I/O
+                std::uintmax_t rounded{((size + page - 1) / page) * page};
+                std::cerr << "Warning: '--block-size' must be a multiple of " << page << " bytes. Using " << rounded << " instead." << std::endl;
+                size = rounded;
+            }
+            Config.updateBlockSize(size);
+        }},
     };
 
     // Parse command-line arguments
@@ -488,6 +2363,11 @@ std::vector<std::string> parseArguments(int argc, char* argv[]) {
         if (arg[0] == '-') {
             if (arg[1] == '-') { // Handle long options
                 std::string longOption{arg.substr(2)}; // Initializes option without '--'
+                longValue.clear();
+                if (auto eq{longOption.find('=')}; eq != std::string::npos) { // Splits '--option=value'
+                    longValue = longOption.substr(eq + 1);
+                    longOption.erase(eq);
+                }
                 std::transform(longOption.begin(), longOption.end(), longOption.begin(), ::tolower); // Will lower-case flag for case insensitivity
 
                 auto action{longOptionActions.find(longOption)}; // Finds option in respective unordered map
@@ -512,8 +2392,28 @@ std::vector<std::string> parseArguments(int argc, char* argv[]) {
         }
     }
 
+    if (Config.getRng() == RNG_AESCTR && !isOpenSSL) { // AES-CTR is only provided through OpenSSL EVP
+        std::cerr << "Warning: '--rng=aesctr' requires an OpenSSL build. Using ChaCha20 instead." << std::endl;
+        Config.rng = RNG_CHACHA;
+    }
+
+    if (Config.getManifest() == "-" && Config.isInternal()) { // The confirmation prompt would consume the manifest
+        errorExit(1, "Option '--from-stdin' can't be combined with '--internal' (use '--from-file' instead)");
+    }
+
+    if (Config.isResume() && Config.getJournal().empty()) { // Nothing to resume from
+        errorExit(1, "Option '--resume' requires '--journal=<path>'");
+    }
+
+    if (!Config.getWipeMount().empty() && Config.isKeep_files()) { // Fill files that are kept would leave the volume full
+        errorExit(1, "Option '--wipe-free-space' can't be combined with '-k'");
+    }
+    if (!Config.getWipeMount().empty() && Config.isSparse()) { // Preallocated fill files are all unwritten extents, which SEEK_DATA reports as holes
+        errorExit(1, "Option '--wipe-free-space' can't be combined with '--sparse'");
+    }
+
     // Ensure at least one file argument is provided
-    if (fileArgs.empty()) {
+    if (fileArgs.empty() && !Config.isBenchmark() && !Config.isSelf_test() && Config.getManifest().empty() && Config.getWipeMount().empty()) {
         errorExit(1, "Incorrect usage. Use '-h' or '--help' for help");
     }
 
@@ -537,30 +2437,43 @@ void processPath(const fs::path& path) {
 
         if (fs::is_directory(path)) {
             if (Config.isRecursive()) { // Processes all files in a directory (recursive required)
-                logMessage(INFO, "Entering directory '" + path.string() + "'...");
+                if (isLogged(INFO)) { logMessage(INFO, "Entering directory '" + path.string() + "'..."); }
+#ifdef _WIN32
                 for (const auto& entry : fs::recursive_directory_iterator(path, Config.isFollow_symlinks() ? fs::directory_options::follow_directory_symlink : fs::directory_options::none)) {
-                    if (fs::is_regular_file(entry)) {
-                        shredFile(entry.path());
+                    if (entry.is_regular_file()) { // Directory entries carry cached attributes on Windows
+                        fileInfo info;
+                        info.size = entry.file_size();
+                        info.device = std::hash<std::string>{}(fs::absolute(entry.path()).root_name().string());
+                        info.symlink = entry.is_symlink();
+                        info.known = true;
+                        dispatchFile(entry.path(), info);
                     }
                 }
+#else
+                walkDirectory(path); // Stats every inode once and feeds the files to the pool (or shreds them inline)
+#endif
+                if (Pool) { Pool->wait(); } // Every file must be gone before the directory can be removed
+                syncDirectories(); // One sync per directory for the whole batch of unlinks
 
                 if (!Config.isKeep_files() && fs::is_empty(path) && !Config.isDry_run()) { // Processes if not keeping files, is a legitimate run, and the directory is empty
                     if (fs::remove(path)) { // Remove directory after after successful deletion of all files
-                        logMessage(INFO, "Directory '" + path.string() + "' successfully deleted.");
+                        if (isLogged(INFO)) { logMessage(INFO, "Directory '" + path.string() + "' successfully deleted."); }
                     } else {
                         logMessage(ERROR, "Failed to delete directory '" + path.string() + "'");
                         Program.updateErrorStatus();
                     }
                 } else { // Directory wasn't deleted: keep files or directory is not empty
                     if (Config.isKeep_files()) { logMessage(WARNING, "Directory '" + path.string() + "' was not deleted (keep_files flag)."); }
-                        else if (!fs::is_empty(path) && !Config.isDry_run()) { logMessage(WARNING, "Directory '" + path.string() + "' is not empty. Skipping deletion."); }
+                        else if (!fs::is_empty(path) && !Config.isDry_run() && !Config.isBenchmark()) { logMessage(WARNING, "Directory '" + path.string() + "' is not empty. Skipping deletion."); }
                         else if (Config.isDry_run()) { logMessage(DRY_RUN, "Directory '" + path.string() + "' would be shredded."); }
                 }
             } else { // No recursive = No shredding
                 logMessage(WARNING, "'" + path.string() + "' is a directory. Use -r for recursive shredding.");
             }
         } else if (fs::is_regular_file(path)) { // For files to shred individually
-            shredFile(path);
+            dispatchFile(path, fileInfo{});
+        } else if (Config.isResume() && Journal.isDone(Journal.key(path))) { // Shredded and deleted by an interrupted run
+            if (isLogged(INFO)) { logMessage(INFO, "'" + path.string() + "' was already shredded (journal). Skipping."); }
         } else { // This file, trash
             logMessage(ERROR, "'" + path.string() + "' is not a valid file or directory.");
             Program.updateErrorStatus();
@@ -577,22 +2490,118 @@ void processPath(const fs::path& path) {
     }
 }
 
-void logMessage(logLevel type, const std::string& message) { // Function to log messages with timestamps
-    std::string level;
-    if (type == INFO) { level = "INFO"; } // To print the actual word rather than the numerical representation.
-    if (type == ERROR) { level = "ERROR"; }
-    if (type == WARNING) { level = "WARNING"; }
-    if (type == DRY_RUN) { level = "DRY_RUN"; }
-    if (type == INTERNAL) { level = "INTERNAL"; }
-    if (Config.isVerbose() || Config.isInternal() || type != INFO ) { // Only print WARNING, ERRORS, or DRY_RUN levels (unless verbose)
-        auto now{std::chrono::system_clock::now()}; // gets current time
-        auto time{std::chrono::system_clock::to_time_t(now)}; // changes time to correct format
-        auto tm{*std::localtime(&time)}; // gets local time
-        std::cout << "[" << std::put_time(&tm, "%m-%d-%Y %H:%M:%S") << "] [" << level << "] " << message << std::endl; // logs in format: [MM-DD-YY] [LEVEL] MESSAGE
+void processManifest(const std::string& source) { // Streams NUL-delimited paths from a file or standard input (one path in memory at a time)
+    std::ifstream manifestFile;
+    if (source != "-") {
+        manifestFile.open(source, std::ios::binary);
+        if (!manifestFile) {
+            logMessage(ERROR, "Failed to open path list '" + source + "'");
+            Program.updateErrorStatus();
+            return;
+        }
     }
+    std::istream& input{source == "-" ? std::cin : manifestFile};
+    std::string path; // Reused for every entry
+    while (std::getline(input, path, '\0')) { // Same format as 'find -print0' / 'xargs -0'
+        if (path.empty()) { continue; }
+        processPath(path); // Files go straight to the pool, which blocks while its queue is full
+    }
+    if (input.bad()) {
+        logMessage(ERROR, "Failed to read path list '" + source + "'");
+        Program.updateErrorStatus();
+    }
+}
+
+void dispatchFile(const fs::path& path, const fileInfo& info) { // Hands a file to the worker pool, or shreds it right away
+    if (Pool) { Pool->submit(path, info); } // Shredded by the next free worker
+        else { shredFile(path, info); }
+}
+
+bool statFile(const fs::path& path, fileInfo& info) { // Fills info with one lstat (plus one stat for symlinks)
+#ifdef _WIN32
+    std::error_code ec{};
+    info.symlink = fs::is_symlink(path, ec);
+    info.size = fs::file_size(path, ec);
+    if (ec) { return false; }
+    info.device = std::hash<std::string>{}(fs::absolute(path).root_name().string());
+#else
+    struct stat fileStat;
+    if (lstat(path.c_str(), &fileStat) != 0) { return false; }
+    info.symlink = S_ISLNK(fileStat.st_mode);
+    Stats.addSyscalls(info.symlink ? 2 : 1);
+    if (info.symlink && stat(path.c_str(), &fileStat) != 0) { return false; } // Dangling symlink
+    info.size = static_cast<std::uintmax_t>(fileStat.st_size);
+    info.device = static_cast<std::uintmax_t>(fileStat.st_dev);
+    info.blockSize = static_cast<std::uintmax_t>(fileStat.st_blksize);
+    info.mode = static_cast<unsigned int>(fileStat.st_mode);
+    info.uid = static_cast<unsigned int>(fileStat.st_uid);
+    info.gid = static_cast<unsigned int>(fileStat.st_gid);
+#endif
+    info.known = true;
+    return true;
+}
+
+#ifndef _WIN32
+static void fillInfo(const struct stat& fileStat, bool symlink, fileInfo& info) { // Copies the traversal's stat into the job metadata
+    info.size = static_cast<std::uintmax_t>(fileStat.st_size);
+    info.device = static_cast<std::uintmax_t>(fileStat.st_dev);
+    info.blockSize = static_cast<std::uintmax_t>(fileStat.st_blksize);
+    info.mode = static_cast<unsigned int>(fileStat.st_mode);
+    info.uid = static_cast<unsigned int>(fileStat.st_uid);
+    info.gid = static_cast<unsigned int>(fileStat.st_gid);
+    info.symlink = symlink;
+    info.known = true;
+}
+
+void walkDirectory(const fs::path& root) { // Walks a tree with the shared core (fsCore.h), one stat per inode, feeding files to the pool
+    walkCounters counters; // Walker system calls are folded into --stats afterwards
+    walkOptions options;
+    options.jobs = Pool ? static_cast<unsigned>(Config.getJobs()) : 1; // Without a pool, files are shredded inline, one at a time
+    options.followFileSymlinks = Config.isFollow_symlinks(); // Without -e, links are skipped here and never opened
+    options.followDirectorySymlinks = Config.isFollow_symlinks();
+    options.counters = &counters;
+
+    walkVisitor visitor;
+    visitor.file = [](int, const char*, const std::string& path, const struct stat& fileStat, bool symlink) { // Links are decided here, where their type is known
+        fileInfo info;
+        fillInfo(fileStat, false, info); // The job always gets a plain file: either this entry or a resolved link target
+        if (!symlink) {
+            dispatchFile(path, info);
+            return true; // Shred failures are recorded in Program by shredFile()
+        }
+        if (!Config.isFollow_symlinks()) { return true; } // The walker skips links without -e; never shredded through the link
+        std::error_code ec{};
+        fs::path target{fs::canonical(path, ec)}; // Resolved once; fileStat already describes this target
+        if (ec) {
+            logMessage(WARNING, "Dangling symlink (not followed): '" + path + "'");
+            return true;
+        }
+        if (isLogged(INFO)) { logMessage(INFO, "Following symlink '" + path + "' to '" + target.string() + "'"); }
+        dispatchFile(target, info);
+        return true;
+    };
+    visitor.error = [](const std::string& message) {
+        logMessage(ERROR, message);
+        Program.updateErrorStatus();
+    };
+    visitor.warning = [](const std::string& message) { logMessage(WARNING, message); };
+
+    walkTree(root.string(), options, visitor);
+    Stats.addSyscalls(counters.syscalls.load(std::memory_order_relaxed));
+}
+#endif
+
+bool isLogged(logLevel type) { // Whether a message of this level is printed or logged (checked before building the message)
+    return type != INFO || Config.isVerbose() || Config.isInternal() || !Config.getLogFile().empty();
+}
+
+void logMessage(logLevel type, const std::string& message) { // Function to log messages with timestamps (queued for the writer thread)
+    if (!isLogged(type)) { return; }
+    Logger.log(type, message);
 }
 
 void errorExit(int value, std::string message, std::string flag, bool customLogger) { // Function to provide ability to exit program outside of main function
+    Logger.flush(); // Queued lines come before the error
     if (customLogger) { 
         if (!message.empty() && flag.empty()) {
             logMessage(ERROR, message);
@@ -609,34 +2618,241 @@ void errorExit(int value, std::string message, std::string flag, bool customLogg
     exit(value);
 }
 
-std::uintmax_t getOptimalBlockSize() { // This function returns the retrieves blocksize defined in the kernel for the current OS.
 #ifdef __linux__
-    struct statvfs fsInfo;
-    if (statvfs(".", &fsInfo) != 0) {
-        logMessage(ERROR, "Error getting block size on Linux. Defaulting to 4096 bytes.");
-        return 4096;  // Default block size if statvfs fails
-    }
-    return fsInfo.f_frsize;  // f_frsize is the optimal block size
-#elif _WIN32
-    DWORD sectorsPerCluster, bytesPerSector, numberOfFreeClusters, totalNumberOfClusters;
-    if (!GetDiskFreeSpace(".", &sectorsPerCluster, &bytesPerSector, &numberOfFreeClusters, &totalNumberOfClusters)) {
-        logMessage(ERROR, "Error getting block size on Windows. Defaulting to 4096 bytes.");
-        return 4096;  // Default block size if GetDiskFreeSpace fails
-    }
-    return sectorsPerCluster * bytesPerSector;  // This is the block size
-#elif __APPLE__
-    int blockSize{};
-    size_t len{sizeof(blockSize)};
-
-    if (sysctlbyname("kern.maxfiles", &blockSize, &len, NULL, 0) != 0) {
-        logMessage(ERROR, "Error getting block size on MacOS. Defaulting to 4096 bytes.");
-        return 4096; // Default block size if sysctl fails
-    }
-    return blockSize; // blockSize is the optimal block size
+static std::uintmax_t readSysfsNumber(const fs::path& file) { // Reads a single number from a sysfs attribute (0 if missing)
+    std::ifstream in(file);
+    std::uintmax_t value{};
+    if (in >> value) { return value; }
+    return 0;
+}
+#endif
+
+bool isRotationalDevice(std::uintmax_t device) { // Whether the device is a spinning disk (only known on Linux)
+#ifdef __linux__
+    dev_t dev{static_cast<dev_t>(device)};
+    std::error_code ec{};
+    fs::path devPath{fs::canonical("/sys/dev/block/" + std::to_string(major(dev)) + ":" + std::to_string(minor(dev)), ec)};
+    if (ec) { return false; } // Not a block device (tmpfs, network file systems, ...)
+    fs::path queue{devPath / "queue"};
+    if (!fs::exists(queue / "rotational", ec)) { queue = devPath.parent_path() / "queue"; } // Partitions use the parent disk's queue
+    return readSysfsNumber(queue / "rotational") == 1;
+#else
+    (void)device;
+    return false;
+#endif
+}
+
+ioGeometry getOptimalBlockSize(const fs::path& filePath, const fileInfo& info) { // Determines the I/O transfer size for a file from its file system and device
+    const std::uintmax_t defaultTarget{4 * 1024 * 1024}; // 4 MiB transfers keep syscall count low without hurting small files
+    const std::uintmax_t maxTarget{8 * 1024 * 1024}; // Upper bound unless the stripe itself is larger
+    const std::uintmax_t pageSize{alignedBuffer::pageSize()};
+    const std::uintmax_t fileSize{info.size};
+    ioGeometry geo;
+
+    // Device hints only depend on the device, so they are looked up once per device rather than once per file
+    struct deviceHints {
+        std::uintmax_t clusterSize{}; // Windows cluster size
+        std::uintmax_t deviceOptimal{};
+        std::uintmax_t stripeWidth{};
+        bool rotational{false};
+    };
+    static std::mutex hintsLock;
+    static std::unordered_map<std::uintmax_t, deviceHints> hintsCache;
+    deviceHints hints;
+    bool cached{false};
+    {
+        std::lock_guard<std::mutex> guard(hintsLock);
+        auto found{hintsCache.find(info.device)};
+        if (found != hintsCache.end()) { hints = found->second; cached = true; }
+    }
+
+    if (!cached) {
+#ifdef _WIN32
+        DWORD sectorsPerCluster, bytesPerSector, numberOfFreeClusters, totalNumberOfClusters;
+        std::string root{fs::absolute(filePath).root_path().string()};
+        if (GetDiskFreeSpace(root.c_str(), &sectorsPerCluster, &bytesPerSector, &numberOfFreeClusters, &totalNumberOfClusters)) {
+            hints.clusterSize = sectorsPerCluster * bytesPerSector;  // Cluster size
+        }
+#elif defined(__linux__)
+        // Device hints from sysfs (partitions keep their queue limits on the parent disk)
+        dev_t device{static_cast<dev_t>(info.device)};
+        hints.rotational = isRotationalDevice(info.device);
+        fs::path dev{"/sys/dev/block/" + std::to_string(major(device)) + ":" + std::to_string(minor(device))};
+        std::error_code ec{};
+        fs::path devPath{fs::canonical(dev, ec)};
+        if (!ec) {
+            fs::path queue{devPath / "queue"};
+            if (!fs::exists(queue / "optimal_io_size", ec)) { queue = devPath.parent_path() / "queue"; }
+            hints.deviceOptimal = std::max(readSysfsNumber(queue / "optimal_io_size"), readSysfsNumber(queue / "minimum_io_size"));
+
+            std::uintmax_t chunk{readSysfsNumber(devPath / "md" / "chunk_size")}; // Software RAID stripe width
+            std::uintmax_t disks{readSysfsNumber(devPath / "md" / "raid_disks")};
+            if (chunk > 0 && disks > 0) {
+                std::string level;
+                std::ifstream levelFile(devPath / "md" / "level");
+                levelFile >> level;
+                std::uintmax_t parity{level == "raid5" ? 1u : (level == "raid6" ? 2u : 0u)};
+                std::uintmax_t dataDisks{level == "raid10" ? std::max<std::uintmax_t>(disks / 2, 1) : (disks > parity ? disks - parity : 1)};
+                if (level != "raid1") { hints.stripeWidth = chunk * dataDisks; }
+            }
+        }
+#elif defined(__APPLE__)
+        struct statfs fsInfo;
+        if (statfs(filePath.c_str(), &fsInfo) == 0) { hints.deviceOptimal = static_cast<std::uintmax_t>(fsInfo.f_iosize); } // Optimal transfer size
+#endif
+        std::lock_guard<std::mutex> guard(hintsLock);
+        hintsCache.emplace(info.device, hints);
+    }
+
+#ifdef _WIN32
+    geo.fsBlockSize = hints.clusterSize;
+#else
+    geo.fsBlockSize = info.blockSize; // Preferred I/O size of the file system (from the traversal's stat)
+#endif
+    if (geo.fsBlockSize == 0) {
+        logMessage(WARNING, "Error getting block size for '" + filePath.string() + "'. Defaulting to 4096 bytes.");
+        geo.fsBlockSize = 4096;
+    }
+    geo.deviceOptimal = hints.deviceOptimal;
+    geo.stripeWidth = hints.stripeWidth;
+    geo.rotational = hints.rotational;
+
+    // Every transfer is a whole number of pages, file system blocks, device optimal units and stripes
+    std::uintmax_t granularity{std::max({pageSize, geo.fsBlockSize, geo.deviceOptimal, geo.stripeWidth})};
+    granularity = ((granularity + pageSize - 1) / pageSize) * pageSize;
+
+    if (Config.getBlockSize() > 0) { // User override, rounded up to whole pages so direct I/O transfers stay aligned
+        geo.blockSize = ((Config.getBlockSize() + pageSize - 1) / pageSize) * pageSize;
+        geo.overridden = true;
+    } else if (granularity >= maxTarget) {
+        geo.blockSize = granularity;
+    } else {
+        geo.blockSize = ((defaultTarget + granularity - 1) / granularity) * granularity;
+        if (geo.blockSize > maxTarget) { geo.blockSize = granularity; }
+    }
+
+    // Small files don't need a full-size buffer
+    std::uintmax_t fileRounded{((fileSize + granularity - 1) / granularity) * granularity};
+    if (!geo.overridden && fileRounded > 0 && fileRounded < geo.blockSize) { geo.blockSize = fileRounded; }
+    return geo;
+}
+
+bool parseSize(const std::string& text, std::uintmax_t& value) { // Parses sizes like 4096, 512K, 4M, 1G (binary units)
+    size_t end{};
+    unsigned long long number{};
+    try { number = std::stoull(text, &end); } catch (...) { return false; }
+    std::string suffix{text.substr(end)};
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+    std::uintmax_t multiplier{1};
+    if (suffix.empty() || suffix == "b") { multiplier = 1; }
+    else if (suffix == "k" || suffix == "kib" || suffix == "kb") { multiplier = 1024ULL; }
+    else if (suffix == "m" || suffix == "mib" || suffix == "mb") { multiplier = 1024ULL * 1024; }
+    else if (suffix == "g" || suffix == "gib" || suffix == "gb") { multiplier = 1024ULL * 1024 * 1024; }
+    else { return false; }
+    if (number == 0) { return false; }
+    value = static_cast<std::uintmax_t>(number) * multiplier;
+    return true;
+}
+
+std::vector<std::vector<extent>> splitRanges(const std::vector<extent>& map, std::uintmax_t blockSize, int threads) { // Splits the extents to overwrite into up to 'threads' groups of whole blocks
+    std::uintmax_t blocks{};
+    for (const extent& range : map) { blocks += (range.length + blockSize - 1) / blockSize; }
+    std::uintmax_t count{std::max<std::uintmax_t>(1, std::min<std::uintmax_t>(static_cast<std::uintmax_t>(std::max(threads, 1)), blocks))};
+    std::uintmax_t perRange{((blocks + count - 1) / count) * blockSize}; // Whole blocks per group
+    std::vector<std::vector<extent>> ranges(1);
+    std::uintmax_t filled{}; // Bytes (rounded up to whole blocks) in the current group
+    for (extent range : map) {
+        while (range.length > 0) { // Extents crossing a group boundary are split a whole number of blocks from their start
+            if (filled == perRange) { ranges.emplace_back(); filled = 0; }
+            std::uintmax_t take{std::min(range.length, perRange - filled)};
+            ranges.back().push_back({range.offset, take});
+            filled += ((take + blockSize - 1) / blockSize) * blockSize;
+            range.offset += take;
+            range.length -= take;
+        }
+    }
+    return ranges;
+}
+
+bool forEachBlock(const std::vector<extent>& extents, std::uintmax_t blockSize, const std::function<bool(std::uintmax_t, size_t)>& visit) { // Visits every block of the extents in order; stops (returning false) once visit() does
+    for (const extent& range : extents) {
+        for (std::uintmax_t offset = range.offset; offset < range.offset + range.length; offset += blockSize) {
+            if (!visit(offset, static_cast<size_t>(std::min<std::uintmax_t>(blockSize, range.offset + range.length - offset)))) { return false; }
+        }
+    }
+    return true;
+}
+
+std::vector<extent> extentsFrom(const std::vector<extent>& extents, std::uintmax_t offset) { // The part of the extents at or above offset (rounded down to a page for direct I/O)
+    offset -= offset % alignedBuffer::pageSize();
+    std::vector<extent> remaining;
+    for (const extent& range : extents) {
+        if (range.offset + range.length <= offset) { continue; } // Entirely below
+        std::uintmax_t start{std::max(range.offset, offset)};
+        remaining.push_back({start, range.offset + range.length - start});
+    }
+    return remaining;
+}
+
+std::vector<extent> allocatedExtents(rawFile& file, std::uintmax_t fileSize) { // Data extents of the open file (the whole file if holes can't be queried)
+    std::vector<extent> map;
+#ifdef _WIN32
+    FILE_ALLOCATED_RANGE_BUFFER query{}, ranges[64];
+    query.FileOffset.QuadPart = 0;
+    query.Length.QuadPart = static_cast<LONGLONG>(fileSize);
+    while (true) {
+        DWORD returned{};
+        BOOL ok{DeviceIoControl(file.nativeHandle(), FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query), ranges, sizeof(ranges), &returned, NULL)};
+        if (!ok && GetLastError() != ERROR_MORE_DATA) { return {{0, fileSize}}; } // Not supported: overwrite everything
+        DWORD count{returned / static_cast<DWORD>(sizeof(FILE_ALLOCATED_RANGE_BUFFER))};
+        for (DWORD r = 0; r < count; ++r) { map.push_back({static_cast<std::uintmax_t>(ranges[r].FileOffset.QuadPart), static_cast<std::uintmax_t>(ranges[r].Length.QuadPart)}); }
+        if (ok || count == 0) { break; }
+        LONGLONG next{ranges[count - 1].FileOffset.QuadPart + ranges[count - 1].Length.QuadPart}; // Continues after the last range returned
+        query.Length.QuadPart = static_cast<LONGLONG>(fileSize) - next;
+        query.FileOffset.QuadPart = next;
+    }
+#elif defined(SEEK_DATA) && defined(SEEK_HOLE)
+    int fd{file.nativeHandle()}; // Moving the file offset is harmless: every transfer is positioned
+    off_t end{static_cast<off_t>(fileSize)}, position{0};
+    while (position < end) {
+        off_t data{lseek(fd, position, SEEK_DATA)};
+        if (data == -1 && errno == ENXIO) { break; } // Only a hole remains
+        if (data == -1) { return {{0, fileSize}}; } // Not supported by this file system: overwrite everything
+        if (data >= end) { break; }
+        off_t hole{lseek(fd, data, SEEK_HOLE)}; // End of file counts as a hole
+        if (hole == -1 || hole > end) { hole = end; }
+        map.push_back({static_cast<std::uintmax_t>(data), static_cast<std::uintmax_t>(hole - data)});
+        position = hole;
+    }
+    Stats.addSyscalls(map.size() * 2 + 1);
 #else
-    logMessage(INFO, "OS type could not be determined. Using default block size (4096 bytes)")
-    return 4096;  // Default block size for unsupported platforms
+    (void)file;
+    map.push_back({0, fileSize});
 #endif
+    return map;
+}
+
+bool runParallel(size_t count, const std::function<void(size_t)>& work) { // Runs work(0..count-1) on one thread each and waits for all (the barrier)
+    std::atomic<bool> ok{true};
+    auto guarded{[&](size_t index) {
+        try {
+            work(index);
+        } catch (const std::exception& e) {
+            logMessage(ERROR, "Range " + std::to_string(index) + " failed: " + std::string(e.what()));
+            ok = false;
+        }
+    }};
+    if (count == 1) { guarded(0); return ok; } // No thread for the common single-range case
+    std::vector<std::thread> workers;
+    for (size_t index = 0; index < count; ++index) { workers.emplace_back(guarded, index); }
+    for (auto& worker : workers) { worker.join(); }
+    return ok;
+}
+
+std::vector<unsigned char> combineDigests(const std::vector<std::vector<unsigned char>>& digests) { // Digest over the per-range digests, in range order
+    streamDigest combined(Config.getHash());
+    for (const auto& digest : digests) { combined.update(digest.data(), digest.size()); }
+    return combined.finish();
 }
 
 std::string generateRandomFileName(size_t length) {
@@ -652,151 +2868,232 @@ std::string generateRandomFileName(size_t length) {
     return randomName;
 }
 
-void syncFile(const fs::path& filePath) {
+void cleanupMetadata(rawFile& file) { // Strips extended attributes and permission bits through the open handle (no path lookups)
+    phaseTimer timer(PHASE_UNLINK);
 #ifdef _WIN32
-    HANDLE hFile{CreateFile(
-        filePath.c_str(), // The file
-        GENERIC_WRITE, // To flush the file
-        0, // Do not share
-        NULL, // Default security
-        OPEN_EXISTING, // Open the file
-        FILE_ATTRIBUTE_NORMAL, // Normal attributes
-        NULL)}; // No template
-    if (hFile == INVALID_HANDLE_VALUE) { // Checks if sync was successful
-        logMessage(WARNING, "File '" + filePath.string() + "' failed to synchronize.");
-        return;
-    }
-    if (!FlushFileBuffers(hFile)) { // Flushes file
-        logMessage(WARNING, "File '" + filePath.string() + "' failed to flush.");
-    }
-    CloseHandle(hFile);
+    (void)file; // Alternate data streams are removed by unlinkObfuscated() once the handle is closed
 #else
-    FILE* file{fopen(filePath.c_str(), "r")}; // Opens the file
-    for (int openCount = 0; openCount < 3; ++openCount) {
-        if (file) { // Syncs/flushes the file
-            fsync(fileno(file));
-            fclose(file);
-            break;
+    int fd{file.nativeHandle()};
+#ifdef __APPLE__
+    ssize_t len{flistxattr(fd, nullptr, 0, 0)}; // Retrieves length of attribute names
+#else
+    ssize_t len{flistxattr(fd, nullptr, 0)}; // Retrieves length of attribute names
+#endif
+    if (len > 0) { // Removes every attribute by name
+        std::vector<char> attrs(static_cast<size_t>(len));
+#ifdef __APPLE__
+        len = flistxattr(fd, attrs.data(), attrs.size(), 0);
+#else
+        len = flistxattr(fd, attrs.data(), attrs.size());
+#endif
+        for (ssize_t i = 0; i < len; i += strlen(&attrs[i]) + 1) {
+#ifdef __APPLE__
+            Stats.addSyscalls();
+            if (fremovexattr(fd, &attrs[i], 0) != 0) { logMessage(WARNING, "Failed to remove attribute '" + std::string(&attrs[i]) + "'"); }
+#else
+            Stats.addSyscalls();
+            if (fremovexattr(fd, &attrs[i]) != 0 && errno != ENODATA) { logMessage(WARNING, "Failed to remove attribute '" + std::string(&attrs[i]) + "'"); }
+#endif
         }
-        file = fopen(filePath.c_str(), "r"); // Attempt to re-open file
-        if (openCount == 3) { logMessage(WARNING, "File '" + filePath.string() + "' failed to flush."); break; }
     }
+    fchmod(fd, 0); // Remove file permissions
+    Stats.addSyscalls(len > 0 ? 3 : 2); // flistxattr (twice when attributes exist) and fchmod
 #endif
 }
 
-void cleanupMetadata(std::string& filePath) {
+bool unlinkObfuscated(const fs::path& filePath) { // Renames the file to a random name in its own directory, then unlinks it
+    phaseTimer timer(PHASE_UNLINK);
+    fs::path parent{filePath.parent_path().empty() ? fs::path(".") : filePath.parent_path()};
 #ifdef _WIN32
-    if (!DeleteFile((filePath + ":$DATA").c_str());) { // Remove the file's DATA stream
-        DWORD lastError{GetLastError()};
-        logMessage(WARNING, "The file's metadata failed to stripped." + std::to_string(lastError));
+    WIN32_FIND_STREAM_DATA stream;
+    HANDLE find{FindFirstStreamW(filePath.c_str(), FindStreamInfoStandard, &stream, 0)};
+    if (find != INVALID_HANDLE_VALUE) { // Deletes named alternate data streams (the unnamed '::$DATA' stream is the file itself)
+        do {
+            if (std::wstring(stream.cStreamName) != L"::$DATA") { DeleteFileW((filePath.wstring() + stream.cStreamName).c_str()); }
+        } while (FindNextStreamW(find, &stream));
+        FindClose(find);
     }
+    fs::path obfuscatedPath{parent / generateRandomFileName()}; // Same directory, so the rename never crosses volumes
+    if (MoveFileExW(filePath.c_str(), obfuscatedPath.c_str(), MOVEFILE_WRITE_THROUGH)) {
+        if (DeleteFileW(obfuscatedPath.c_str())) { return true; }
+        return false;
+    }
+    return DeleteFileW(filePath.c_str()) != 0; // Rename refused: delete under the original name
 #else
-    try {
-#ifdef __APPLE__
-        ssize_t len{listxattr(filePath.c_str(), nullptr, 0, 0)}; // Retrieves length of attributes
-#else
-        ssize_t len{listxattr(filePath.c_str(), nullptr, 0)}; // Retrieves length of attributes
-#endif
-        if (len > 0) { // Iterates through file attributes and removes them
-            std::vector<char> attrs(len); // Dynamically allocates attribution size to size of len
-#ifdef __APPLE__
-            len = listxattr(filePath.c_str(), attrs.data(), attrs.size(), 0); // Gets length again and writes data to attrs variable
+    int dirfd{open(parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+    if (dirfd == -1) { return std::remove(filePath.c_str()) == 0; }
+    std::string name{filePath.filename().string()};
+    std::string randomName{};
+    for (int attempt = 0; attempt < 3; ++attempt) { // Same directory, so the rename never crosses file systems
+        std::string candidate{generateRandomFileName()};
+#ifdef __linux__
+        int renamed{renameat2(dirfd, name.c_str(), dirfd, candidate.c_str(), RENAME_NOREPLACE)};
+        if (renamed == -1 && (errno == ENOSYS || errno == EINVAL)) { renamed = renameat(dirfd, name.c_str(), dirfd, candidate.c_str()); } // Older kernels / file systems
 #else
-            len = listxattr(filePath.c_str(), attrs.data(), attrs.size()); // Gets length again and writes data to attrs variable
+        int renamed{renameat(dirfd, name.c_str(), dirfd, candidate.c_str())};
 #endif
-            for (ssize_t i = 0; i < len; i += strlen(&attrs[i]) + 1) { // Iterates 'len' times though 'attrs'
-#ifdef __APPLE__
-                removexattr(filePath.c_str(), &attrs[i], 0); // Remove attr number 'i'
-#else
-                removexattr(filePath.c_str(), &attrs[i]); // Remove attr number 'i'
+        Stats.addSyscalls();
+        if (renamed == 0) { randomName = candidate; break; }
+        if (errno != EEXIST) { break; }
+    }
+    bool removed{unlinkat(dirfd, randomName.empty() ? name.c_str() : randomName.c_str(), 0) == 0}; // Unlinks under whichever name it has now
+    close(dirfd);
+    Stats.addSyscalls(3); // open, unlinkat and close of the parent directory
+    if (removed) {
+        std::lock_guard<std::mutex> guard(dirSyncMutex);
+        pendingDirSyncs.insert(parent.string());
+    }
+    return removed;
 #endif
-            }
-        }
-    } catch (...) {
-        logMessage(WARNING, "Failed to get and remove file attributes.");
+}
+
+void syncDirectories() { // Syncs every directory with pending unlinks once (replaces the fixed per-file sleeps)
+    std::unordered_set<std::string> directories;
+    {
+        std::lock_guard<std::mutex> guard(dirSyncMutex);
+        directories.swap(pendingDirSyncs);
+    }
+#ifndef _WIN32
+    for (const auto& directory : directories) {
+        int dirfd{open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+        if (dirfd == -1) { continue; } // Already removed
+        fsync(dirfd);
+        close(dirfd);
     }
 #endif
 }
 
+int verifyWithHash(const std::string& filePath, rawFile& file, const std::vector<std::vector<extent>>& ranges, std::uintmax_t bufferSize, const std::vector<unsigned char>& expectedDigest, const int& pass) {
 #ifdef OPENSSL_FOUND
-    std::string computeSHA256(const std::vector<unsigned char>& data) { // Gets SHA256 hash
-        EVP_MD_CTX *mdctx{EVP_MD_CTX_new()}; // Initializes context
-        const EVP_MD *md{EVP_sha256()}; // Sets mode to SHA256
-        unsigned char hash[EVP_MAX_MD_SIZE]{}; // Buffer for hash
-        unsigned int hashLen{}; // Length for hash
-
-        if (mdctx == nullptr) { // If it failed to initialize
-            logMessage(ERROR, "Failed to create OpenSSL EVP context for SHA256.");
-            return "";
+    hash.updateVerification(false);
+#endif
+    std::vector<std::vector<unsigned char>> rangeDigests(ranges.size()); // Digest of the data read back from each range
+    std::atomic<bool> readFailed{false};
+    bool finished{runParallel(ranges.size(), [&](size_t index) {
+        streamDigest fileDigest(Config.getHash());
+        if (Config.getQueueDepth() > 1) { // This thread reads ahead while the pipeline's thread hashes
+            blockPipeline pipe(static_cast<size_t>(Config.getQueueDepth()), bufferSize, [&](const unsigned char* data, size_t size, std::uintmax_t) {
+                fileDigest.update(data, size);
+                return true;
+            });
+            bool read{forEachBlock(ranges[index], bufferSize, [&](std::uintmax_t offset, size_t readSize) {
+                unsigned char* block{pipe.acquire()};
+                if (!block || !file.readAt(block, readSize, offset)) { return false; } // If the file can't be read back
+                pipe.submit(readSize, offset);
+                return true;
+            })};
+            pipe.finish();
+            if (!read) {
+                logMessage(ERROR, "File " + filePath + " failed to be read back for hashing.");
+                readFailed = true;
+                return;
+            }
+            rangeDigests[index] = fileDigest.finish();
+            return;
         }
-
-        if (EVP_DigestInit_ex(mdctx, md, nullptr) != 1) { // Initialize the context with the mode
-            EVP_MD_CTX_free(mdctx); // Frees context
-            logMessage(ERROR, "Failed to initialize OpenSSL SHA256 context.");
-            return "";
+        pooledBuffer verifyBuffer(bufferSize); // Verification only ever holds one block per range
+        bool read{forEachBlock(ranges[index], bufferSize, [&](std::uintmax_t offset, size_t readSize) { // Streams the range block by block (constant memory)
+            if (!file.readAt(verifyBuffer.data(), readSize, offset)) { return false; } // If the file can't be read back
+            fileDigest.update(verifyBuffer.data(), readSize);
+            return true;
+        })};
+        if (!read) {
+            logMessage(ERROR, "File " + filePath + " failed to be read back for hashing.");
+            readFailed = true;
+            return;
         }
+        rangeDigests[index] = fileDigest.finish();
+    })};
+    if (!finished || readFailed) { return 1; }
 
-        if (EVP_DigestUpdate(mdctx, data.data(), data.size()) != 1) { // Updates the hash with data
-            EVP_MD_CTX_free(mdctx);
-            logMessage(ERROR, "Failed to update OpenSSL SHA256 context.");
-            return "";
-        }
+    if (combineDigests(rangeDigests) != expectedDigest) { // Only if they are identical will we say it succeeded (raw digest bytes)
+        logMessage(WARNING, "Hash mismatch for '" + filePath + "' on pass " + std::to_string(pass));
+        return 2; // Triggers verification failed for calling function
+    }
+#ifdef OPENSSL_FOUND
+    hash.updateVerification(true);
+#endif
+    return 0; // Triggers verification success
+}
 
-        if (EVP_DigestFinal_ex(mdctx, hash, &hashLen) != 1) { // Finalizes hash calculation
-            EVP_MD_CTX_free(mdctx);
-            logMessage(ERROR, "Failed to finalize OpenSSL SHA256 hash.");
-            return "";
+int verifyWithKeystream(const std::string& filePath, rawFile& file, const std::vector<extent>& extents, pooledBuffer& verifyBuffer, const keystreamSeed& finalSeed, const int& pass) {
+    keystream replay(Config.getRng()); // Regenerates the expected data from the range's seed instead of storing it
+    replay.start(finalSeed);
+    pooledBuffer expected(verifyBuffer.size()); // Expected block (constant memory)
+
+    if (Config.getQueueDepth() > 1) { // This thread reads ahead while the pipeline's thread regenerates and compares
+        std::uintmax_t mismatchAt{}; // Offset of the first differing block
+        blockPipeline pipe(static_cast<size_t>(Config.getQueueDepth()), verifyBuffer.size(), [&](const unsigned char* data, size_t size, std::uintmax_t offset) {
+            replay.fill(expected.data(), size);
+            if (std::memcmp(data, expected.data(), size) == 0) { return true; }
+            mismatchAt = offset;
+            return false;
+        });
+        bool readFailed{false};
+        forEachBlock(extents, verifyBuffer.size(), [&](std::uintmax_t offset, size_t readSize) {
+            unsigned char* block{pipe.acquire()};
+            if (!block) { return false; } // Compare stage already found a mismatch
+            if (!file.readAt(block, readSize, offset)) { readFailed = true; return false; } // If the file can't be read back
+            pipe.submit(readSize, offset);
+            return true;
+        });
+        if (readFailed) {
+            logMessage(ERROR, "File " + filePath + " failed to be read back for verification.");
+            pipe.finish();
+            return 1;
         }
-
-        EVP_MD_CTX_free(mdctx); // Frees the context
-
-        std::ostringstream hexStream; // Opens output stringstream for hex-formatted hash
-        for (unsigned int i = 0; i < hashLen; ++i) {  // Iterates through the hash and formats as hex
-            hexStream << std::setw(2) << std::setfill('0') << std::hex << (int)hash[i];
+        if (!pipe.finish()) { // Check if the data is consistent with the final pass
+            if (Config.isVerbose()) { Logger.raw("Verification failed at offset: " + std::to_string(mismatchAt) + " (pass " + std::to_string(pass) + ")\n", true); }
+            return 2;
         }
-
-        return hexStream.str();
+        return 0;
     }
 
-    int verifyWithHash(const std::string& filePath, const std::vector<unsigned char>& expectedData, const int& pass) {
-        struct hashStat hash;
-        hash.updateVerification(false);
-        std::ifstream file(filePath, std::ios::binary); // Opens input (binary) stream for file (rb)
-        if (!file.is_open()) { // If the file doesn't open
-            logMessage(ERROR, "File " + filePath + "failed to open for hashing. Attempting fallback..");
-            return 1; // Triggers fallback initiation for calling function
+    int result{0};
+    forEachBlock(extents, verifyBuffer.size(), [&](std::uintmax_t offset, size_t readSize) {
+        if (!file.readAt(verifyBuffer.data(), readSize, offset)) { // If the file can't be read back
+            logMessage(ERROR, "File " + filePath + " failed to be read back for verification.");
+            result = 1;
+            return false;
         }
-
-        std::vector<unsigned char> fileContent((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()); // Retrieves files contents
-        file.close(); // Closes file
-
-        std::string fileHash{computeSHA256(fileContent)}; // Calculates hash from file data
-        std::string expectedHash{computeSHA256(expectedData)}; // Calculates hash from saved data
-
-        if (fileHash == expectedHash) { // Only if they are identical will we say it succeeded
-            hash.updateVerification(true);
-        } else {
-            logMessage(WARNING, "Hash mismatch for '" + filePath + "' on pass " + std::to_string(pass));
-            hash.updateVerification(false);
-            return 2; // Triggers verification failed for calling function
+        replay.fill(expected.data(), readSize);
+        if (std::memcmp(verifyBuffer.data(), expected.data(), readSize) != 0) { // Check if the data is consistent with the final pass
+            if (Config.isVerbose()) { Logger.raw("Verification failed at offset: " + std::to_string(offset) + " (pass " + std::to_string(pass) + ")\n", true); }
+            result = 2;
+            return false;
         }
-        return 0; // Triggers verification success
-    }
-#endif
+        return true;
+    });
+    return result;
+}
 
-bool shredFile(const fs::path& filePath) {
+bool shredFile(const fs::path& filePath, fileInfo info) {
     bool verificationFailed{false};
+    auto fileStart{std::chrono::steady_clock::now()}; // For the per-file latency histogram under --stats
     try {
         verificationFailed = false;
+        std::string journalKey{Journal.isOpen() ? Journal.key(filePath) : std::string()}; // Identifies the file in the journal
+        if (Config.isResume() && Journal.isDone(journalKey)) { // Finished by an earlier, interrupted run (only left behind with -k)
+            if (isLogged(INFO)) { logMessage(INFO, "File '" + filePath.string() + "' was already shredded (journal). Skipping."); }
+            return true;
+        }
+        if (!info.known && !statFile(filePath, info)) { // Only files passed directly need a lookup; traversed files carry their stat
+            logMessage(ERROR, "Failed to get file status for '" + filePath.string() + "'");
+            Program.updateErrorStatus();
+            return false;
+        }
         if (Config.isDry_run()) { // Triggers if not deleting
-            if (fs::is_symlink(filePath) && !Config.isFollow_symlinks()) { // Iterates through options for a reliable file iteration
+            if (info.symlink && !Config.isFollow_symlinks()) { // Iterates through options for a reliable file iteration
                 logMessage(DRY_RUN, "Symlink file '" + filePath.string() + "' would not be shredded.");
             } else {
             logMessage(DRY_RUN, "File '" + filePath.string() + "' would be shredded.");
             }
             
             return true;
-        } else if (fs::is_symlink(filePath) && Config.isFollow_symlinks()) {
+        } else if (info.symlink && !Config.isFollow_symlinks()) { // Never overwrite a link's target unless asked to (-e)
+            logMessage(WARNING, "Skipping symlink '" + filePath.string() + "'");
+            return true;
+        } else if (info.symlink && Config.isFollow_symlinks()) {
             auto target{fs::read_symlink(filePath)};
             if (!fs::exists(target)) {
                 logMessage(WARNING, "Dangling symlink (not followed): '" + filePath.string() + "'");
@@ -807,13 +3104,13 @@ bool shredFile(const fs::path& filePath) {
             }
         }
 
-        if (fs::is_empty(filePath)) {
+        if (info.size == 0) {
             logMessage(ERROR, "File '" + filePath.string() + "' is empty and will not be shredded.");
             return false;
         }
 
         // Gets file permissions, aborts if not found
-        hasWritePermission(filePath); // Populate structure with the current file's permissions
+        hasWritePermission(filePath, info); // Populate structure with the current file's permissions
 
         if (Config.isForce_delete()) { // Only if force_delete flag is set
             bool needChange{false};
@@ -835,11 +3132,11 @@ bool shredFile(const fs::path& filePath) {
         if (!wc.isWritePerm()) { logMessage(ERROR, "There are no" + std::string(wc.isReadPerm() ? " " : " read or ") + "write permissions for file '" + filePath.string() + "'"); Program.updateErrorStatus(); return false; }
         if (!wc.isReadPerm()) { logMessage(ERROR, "There are no read permissions for file '" + filePath.string() + "'"); Program.updateErrorStatus(); return false;}
 
-        if (fs::file_size(filePath) == 0) { // Skip the shredding of empty files, delete them immediately.
+        if (info.size == 0) { // Skip the shredding of empty files, delete them immediately.
             if (!Config.isKeep_files()) {
-                logMessage(INFO, "File '" + filePath.string() + "' is empty and will be deleted without overwriting.");
+                if (isLogged(INFO)) { logMessage(INFO, "File '" + filePath.string() + "' is empty and will be deleted without overwriting."); }
                 if (std::remove(filePath.c_str()) == 0) {
-                    logMessage(INFO, "Empty file '" + filePath.string() + "' successfully deleted.");
+                    if (isLogged(INFO)) { logMessage(INFO, "Empty file '" + filePath.string() + "' successfully deleted."); }
                 } else {
                     logMessage(ERROR, "Failed to delete empty file '" + filePath.string() + "'");
                     Program.updateErrorStatus();
@@ -851,13 +3148,25 @@ bool shredFile(const fs::path& filePath) {
             return true;
         }
 
-        auto fileSize{fs::file_size(filePath)}; // get size of file (to know how much to overwrite)
-        std::fstream file; // fstream instead ofstream to prevent appending
+        auto fileSize{info.size}; // size of file from the traversal's stat (to know how much to overwrite)
+        ioGeometry geometry{getOptimalBlockSize(filePath, info)}; // Transfer size for this file
+        if (Config.isInternal() && !ic.wasBufferPrinted()) {
+            logMessage(INTERNAL, "Blocksize: " + std::to_string(geometry.blockSize) + (geometry.overridden ? " (--block-size)" : "") + " [fs: " + std::to_string(geometry.fsBlockSize)
+                       + ", device optimal: " + std::to_string(geometry.deviceOptimal) + ", stripe: " + std::to_string(geometry.stripeWidth) + "]");
+            ic.updateBufferPrintStatus(true);
+        }
+        int fileThreads{Config.getFileThreads()}; // Threads writing separate ranges of this file
+        if (fileThreads == 0) { // Automatic: only large files on non-rotational devices are split (at least 256 MiB per range, at most 8 ranges)
+            const std::uintmax_t minRange{256ULL * 1024 * 1024};
+            int spare{std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / Config.getJobs())}; // Cores left over by the worker pool
+            fileThreads = geometry.rotational ? 1 : static_cast<int>(std::min<std::uintmax_t>({static_cast<std::uintmax_t>(spare), 8, std::max<std::uintmax_t>(fileSize / minRange, 1)}));
+        }
+        if (Config.isInternal() && fileThreads > 1) { logMessage(INTERNAL, "File threads: " + std::to_string(fileThreads)); }
+        rawFile file; // Raw handle (direct I/O unless --buffered or unsupported)
         int attempts{}; // Will initialize this variable as 0
 
         while (attempts < 10) { // Attempts to open file 10 times before quitting (relic now since obsolescense of multithreading [functionality impacts])
-            file.open(filePath, std::ios::binary | std::ios::in | std::ios::out);
-            if (file) { // If file opens, continue
+            if (file.open(filePath, Config.isDirect_io(), !Config.isFollow_symlinks())) { // If file opens, continue
                 break;
             } else { // Otherwise, log the attempt, wait 1/2 second, and try again.
                 attempts++;
@@ -866,58 +3175,55 @@ bool shredFile(const fs::path& filePath) {
             }
         }
 
-        if (!file) { // After the attempts if the file still isn't open, log the error and exit function
+        if (!file.isOpen()) { // After the attempts if the file still isn't open, log the error and exit function
             logMessage(ERROR, "Failed to open file '" + filePath.string() + "' after 10 attempts. Skipping.");
             Program.updateErrorStatus();
             return false;
         }
+        if (Config.isInternal()) { logMessage(INTERNAL, std::string("Direct I/O: ") + (file.isDirect() ? "enabled" : (Config.isDirect_io() ? "unavailable (buffered fallback)" : "disabled"))); }
 
-        for (int i = 0; i < Config.getOverwriteCount(); ++i) { // Call shredder for amount specified in overwriteCount
-            file.seekp(0, std::ios::beg); // Move to beginning of buffer (file)
-            if (overwriteWithRandomData(filePath.string(), file, fileSize, i + 1) == 1) {
+        const bool tracked{Journal.isOpen() && fileSize >= shredJournal::TRACKED_SIZE}; // Large files record passes and watermarks
+        shredJournal::mark resumeAt{}; // Where an interrupted run left off (pass 0, sweep 0, offset 0 = from the start)
+        if (tracked && Config.isResume() && Journal.resumePoint(journalKey, fileSize, resumeAt)) {
+            if (isLogged(INFO)) { logMessage(INFO, "Resuming file '" + filePath.string() + "' at pass " + std::to_string(resumeAt.pass + 1) + ", sweep " + std::to_string(resumeAt.sweep + 1) + ", offset " + std::to_string(resumeAt.watermark)); }
+        }
+        for (int i = resumeAt.pass; i < Config.getOverwriteCount(); ++i) { // Call shredder for amount specified in overwriteCount
+            bool resumed{i == resumeAt.pass}; // Only the interrupted pass starts part way through
+            if (overwriteWithRandomData(filePath.string(), file, fileSize, geometry.blockSize, fileThreads, i + 1, resumed ? resumeAt.sweep : 0, resumed ? resumeAt.watermark : 0, tracked ? &journalKey : nullptr) == 1) {
                 verificationFailed = true; // Overwrite function returns 1 if verification fails
+            } else if (tracked) {
+                Journal.checkpoint(journalKey, {i + 1, 0, 0}, fileSize, false); // Pass is on the media (every sweep ends with a sync)
             }
-            logMessage(INFO, "Completed overwrite pass " + std::to_string(i + 1) + " for file '" + filePath.string() + "'"); // Prints pass count
+            if (isLogged(INFO)) { logMessage(INFO, "Completed overwrite pass " + std::to_string(i + 1) + " for file '" + filePath.string() + "'"); } // Prints pass count
 
-            std::cout << "Progress: " << std::fixed << std::setprecision(1)  // Percent-style progress meter
-                      << ((i + 1) / static_cast<float>(Config.getOverwriteCount())) * 100 << "%\r" << std::flush;
+            if (Config.getJobs() == 1 && !Config.isBenchmark()) { // Percent-style progress meter
+                std::ostringstream progress;
+                progress << "Progress: " << std::fixed << std::setprecision(1) << ((i + 1) / static_cast<float>(Config.getOverwriteCount())) * 100 << "%\r";
+                Logger.raw(progress.str());
+            }
         }
 
         if ((Config.isInternal() && verificationFailed) || (Config.isVerbose() && verificationFailed)) { logMessage(WARNING, "Overwrite verification failed for '" + filePath.string() + "' Skipping deletion."); } // Prints verification failure, only if verbose because overwrite function says it too.
-        file.close(); // Close file, if completed
-        syncFile(filePath); // Force filesystem synchronization
+        if (!Config.isKeep_files() && !verificationFailed) { cleanupMetadata(file); } // Attributes and mode are stripped while the handle is open
+        file.close(); // Close file, if completed (every sweep was already synchronized)
 
         ic.updateBufferPrintStatus(false); // Reset for next file
         
         if (!Config.isKeep_files() && !verificationFailed) { // Delete file after shredding (if not keeping)
-            std::string obfuscatedPath{};
-            try {
-                std::unique_lock<std::mutex> lock(fileMutex); // Acquire file lock
-
-                fs::permissions(filePath, fs::perms::none); // Remove file permissions
-
-                std::string randomFileName{generateRandomFileName()}; // Get a random name
-                obfuscatedPath = fs::temp_directory_path() / randomFileName; // Make a temp path and add the random name
-                fs::rename(filePath, obfuscatedPath); // Move the file to the new temp directory with the random name
-
-                std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Sleep to wait for new metadata to propagate
-                cleanupMetadata(obfuscatedPath); // Cleanup metadata
-                std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Same as above
-            } catch (...) {
-                std::cerr << "An error has occured while obfuscating metadata on the file '" << filePath.string() << "'" << std::endl;
-            }
-
-            if (std::remove(obfuscatedPath.c_str()) == 0 || std::remove(filePath.c_str()) == 0) { // If successfully deleted
-                if (Config.isVerify()) { logMessage(INFO, "File '" + filePath.string() + "' shredded, verified, and deleted."); }
-                    else if (!Config.isVerify()) { logMessage(INFO, "File '" + filePath.string() +"' shredded and deleted without verification."); }
+            if (unlinkObfuscated(filePath)) { // If successfully deleted
+                if (Journal.isOpen()) { Journal.fileDone(journalKey); }
+                if (Config.isVerify() && isLogged(INFO)) { logMessage(INFO, "File '" + filePath.string() + "' shredded, verified, and deleted."); }
+                    else if (!Config.isVerify() && isLogged(INFO)) { logMessage(INFO, "File '" + filePath.string() +"' shredded and deleted without verification."); }
             } else { // Or not
                 logMessage(ERROR, "Failed to delete file '" + filePath.string() + "'");
                 Program.updateErrorStatus();
                 return false;
             }
         } else {
-            logMessage(INFO, "File '" + filePath.string() + "' overwritten without deletion."); // Keep file mode
+            if (isLogged(INFO)) { logMessage(INFO, "File '" + filePath.string() + "' overwritten without deletion."); } // Keep file mode
+            if (Journal.isOpen() && !verificationFailed) { Journal.fileDone(journalKey); }
         }
+        Stats.addFile(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - fileStart).count()));
         return true;
         
     } catch (const fs::filesystem_error& e) {
@@ -931,182 +3237,181 @@ bool shredFile(const fs::path& filePath) {
     }
 }
 
-int overwriteWithRandomData(std::string filePath, std::fstream& file, std::uintmax_t fileSize, int pass) {
-    secureRandom rng;
-#ifndef OPENSSL_FOUND
-    randomizer seed;
-#else
-    secureRandomizer srng;
-#endif
-    const std::uintmax_t bufferSize{getOptimalBlockSize()};  // Get the block size
-    std::vector<char> buffer(bufferSize); // Set buffer to retrieved value (block size)
+void fillRandomData(unsigned char* data, size_t size) { // Fills a caller-supplied buffer with secure random data (with fallback)
+    try {
+        Entropy.fill(data, size);
+    } catch (std::runtime_error& e) {
+        if (!ic.wasFailedUrandomPrinted()) { // Only warn once per pass
+            logMessage(WARNING, std::string(e.what()));
+            ic.updateFailedUrandomStatus(true);
+        }
+        Entropy.fallbackFill(data, size);
+    } catch (...) {
+        logMessage(ERROR, "An unknown error occurred when generating secure random data");
+        Entropy.fallbackFill(data, size);
+    }
+}
+
+int overwriteWithRandomData(std::string filePath, rawFile& file, std::uintmax_t fileSize, std::uintmax_t bufferSize, int threads, int pass, size_t resumeSweep, std::uintmax_t watermark, const std::string* journalKey) {
     ic.updateFailedUrandomStatus(false); // Reset failed to print data warning for next pass (or file)
+    auto passStart{std::chrono::steady_clock::now()}; // For the per-pass throughput under --stats
+
+    // State owned by the thread writing one range (own buffers and keystreams, so ranges never share RNG state)
+    struct rangeState {
+        std::vector<extent> extents; // Part of the extent map this thread overwrites (one extent unless --sparse)
+        pooledBuffer randomData; // Reusable random data buffer (refilled in place for every block, recycled through Arena)
+        keystream ks; // Random pattern engine for the intermediate random fills of this pass
+        keystream finalKs; // Random pattern engine for the final random data (replayed by verification)
+        keystreamSeed seed, finalSeed; // Seeded once per pass from the OS entropy source
+        streamDigest writtenDigest; // Digest of the final random data (kernel backend only)
+        std::vector<extent> resumed; // Extents of the interrupted sweep left to write (above the journal watermark)
+        std::atomic<std::uintmax_t> position{}; // Everything in the range below this offset has been written by the current sweep (--journal)
+        rangeState(std::vector<extent> e, std::uintmax_t size, rngBackend engine) : extents(std::move(e)), randomData(size), ks(engine), finalKs(engine), writtenDigest(Config.getHash()) {}
+    };
+    // Extents to overwrite: the whole file, or (--sparse) only its allocated data, re-queried every pass
+    std::vector<extent> map{Config.isSparse() ? allocatedExtents(file, fileSize) : std::vector<extent>{{0, fileSize}}};
+    std::uintmax_t mappedBytes{};
+    for (const extent& range : map) { mappedBytes += range.length; }
+    if (Config.isInternal() && Config.isSparse()) { logMessage(INTERNAL, "Extents: " + std::to_string(map.size()) + " (" + std::to_string(mappedBytes) + " of " + std::to_string(fileSize) + " bytes allocated)"); }
+
+    std::deque<rangeState> states; // Stable addresses (members are not movable)
+    for (std::vector<extent>& extents : splitRanges(map, bufferSize, threads)) {
+        rangeState& state{states.emplace_back(std::move(extents), bufferSize, Config.getRng())};
+        if (state.ks.getBackend() != RNG_KERNEL) {
+            fillRandomData(state.seed.key, sizeof(state.seed.key)); fillRandomData(state.seed.nonce, sizeof(state.seed.nonce));
+            fillRandomData(state.finalSeed.key, sizeof(state.finalSeed.key)); fillRandomData(state.finalSeed.nonce, sizeof(state.finalSeed.nonce));
+        }
+        state.ks.start(state.seed);
+        state.finalKs.start(state.finalSeed);
+    }
+    const bool replayVerify{Config.isVerify() && states.front().finalKs.getBackend() != RNG_KERNEL}; // Keystreams can be regenerated, kernel data must be hashed
 
     // Patterns for DoD compliance and additional security
-    std::vector<std::string> patterns{
-        std::string(bufferSize, '\x00'),  // Pass of 0x00 (00000000 in binary)
-        std::string(bufferSize, '\xFF'),  // Pass of 0xFF (11111111 in binary)
-        std::string(bufferSize, '\xAA'),  // Pass of 0xAA (10101010 in binary)
-        std::string(bufferSize, '\x55'),  // Pass of 0x55 (01010101 in binary)
-        std::string(bufferSize, '\x0F'),  // Pass of 0x0F (00001111 in binary)
-        std::string(bufferSize, '\xF0'),  // Pass of 0xF0 (11110000 in binary)
-        std::string(bufferSize, '\xCC'),  // Pass of 0xCC (11001100 in binary)
-        std::string(bufferSize, '\x33')   // Pass of 0x33 (00110011 in binary)
+    static const unsigned char patterns[]{
+        0x00,  // Pass of 0x00 (00000000 in binary)
+        0xFF,  // Pass of 0xFF (11111111 in binary)
+        0xAA,  // Pass of 0xAA (10101010 in binary)
+        0x55,  // Pass of 0x55 (01010101 in binary)
+        0x0F,  // Pass of 0x0F (00001111 in binary)
+        0xF0,  // Pass of 0xF0 (11110000 in binary)
+        0xCC,  // Pass of 0xCC (11001100 in binary)
+        0x33   // Pass of 0x33 (00110011 in binary)
     };
 
-    int securePasses(patterns.size());  // Number of secure passes (to change add/remove from patterns array)
-    
-    std::vector<unsigned char> lastRandomData(fileSize); // For verification
-#ifndef OPENSSL_FOUND
-        // Secure random generator
-        auto& gen = seed.getGenerator(); // Checks if the generator is ready to be reseeded, if so reseed
-        auto& rd = seed.getDevice(); // Gets the random device
-        std::uniform_int_distribution<> dist(0, 255); // Sets even distribution for data generation
-#endif
-    for (std::uintmax_t offset = 0; offset < fileSize; offset += bufferSize) {
-        std::uintmax_t writeSize{std::min(bufferSize, fileSize - offset)}; // Finds writesize        
-        // Generate random data for non-secure or final pass
-        if (!Config.isSecure_mode()) {
-            std::vector<unsigned char> randomData;
-            try {
-                randomData = rng.generate(writeSize);
-            } catch (std::runtime_error& e) {
-                if (!ic.wasFailedUrandomPrinted()) {
-                    logMessage(WARNING, std::string(e.what()));
-                    ic.updateFailedUrandomStatus(true);
-                }
-#ifndef OPENSSL_FOUND
-                randomData.resize(writeSize);
-                std::generate(randomData.begin(), randomData.end(), [&](){ return static_cast<char>(dist(gen)); });
-#else
-                try { randomData = srng.reseedIfNecessary(writeSize); } catch (...) { throw; }
-#endif                
-            } catch (...) {
-                logMessage(ERROR, "An unknown error occurred when generating secure random data");
-#ifndef OPENSSL_FOUND
-                randomData.resize(writeSize);
-                std::generate(randomData.begin(), randomData.end(), [&](){ return static_cast<char>(dist(gen)); });
-#else
-                try { randomData = srng.reseedIfNecessary(writeSize); } catch (...) { throw; }
-#endif      
+    // Builds the sweep plan: each entry is written over the whole file sequentially before the next one starts
+    std::vector<sweepSpec> sweeps;
+    if (Config.isSecure_mode()) { // Secure shredding mode with multiple patterns (defined and random, plus DoD standards)
+        for (size_t p = 0; p < sizeof(patterns); ++p) {
+            sweeps.push_back({false, false, patterns[p]}); // Apply a pre-set pattern
+            if (p % 2 == 1) { sweeps.push_back({true, false, 0}); } // Introduce random pattern for every other pattern for additional security
+        }
+        sweeps.push_back({false, false, 0x00}); // DoD pass 1: Overwrite with 0x00
+        sweeps.push_back({false, false, 0xFF}); // DoD pass 2: Overwrite with 0xFF
+    }
+    sweeps.push_back({true, true, 0}); // Final pass (DoD pass 3 in secure mode): Overwrite with random data (verified)
+
+    // Resuming from the journal: earlier sweeps of this pass are skipped and the interrupted one starts at the watermark
+    if (resumeSweep >= sweeps.size()) { resumeSweep = 0; watermark = 0; } // Recorded with other options (e.g., without -s), so the pass starts over
+    if (watermark > 0) { for (rangeState& state : states) { state.resumed = extentsFrom(state.extents, watermark); } }
+    auto sweepExtents{[&](rangeState& state, size_t sweep) -> const std::vector<extent>& { return (watermark > 0 && sweep == resumeSweep) ? state.resumed : state.extents; }};
+
+    std::atomic<std::uintmax_t> sinceCheckpoint{0}; // Bytes written since the last watermark record
+    auto recordProgress{[&](rangeState& state, std::uintmax_t end, size_t size, size_t sweep) { // Advances the range and writes a watermark every CHECKPOINT_BYTES
+        if (!journalKey) { return; }
+        state.position.store(end, std::memory_order_release);
+        if (sinceCheckpoint.fetch_add(size) + size < shredJournal::CHECKPOINT_BYTES) { return; }
+        if (sinceCheckpoint.exchange(0) < shredJournal::CHECKPOINT_BYTES) { return; } // Another range thread already took this checkpoint
+        std::uintmax_t mark{UINTMAX_MAX}; // Lowest offset any range still has to write (everything below it is written)
+        for (rangeState& other : states) { mark = std::min(mark, other.position.load(std::memory_order_acquire)); }
+        if (mark == UINTMAX_MAX || !file.sync()) { return; } // Sweep is ending anyway, or the data can't be made durable yet
+        Journal.checkpoint(*journalKey, {pass - 1, sweep, mark}, fileSize, true);
+    }};
+
+    for (size_t sweep = resumeSweep; sweep < sweeps.size(); ++sweep) {
+        const sweepSpec& spec{sweeps[sweep]};
+        std::atomic<bool> writeFailed{false};
+        for (rangeState& state : states) { // Each range starts at its first block
+            const std::vector<extent>& extents{sweepExtents(state, sweep)};
+            state.position = extents.empty() ? UINTMAX_MAX : extents.front().offset;
+        }
+        bool finished{runParallel(states.size(), [&](size_t index) { // Every range is written by its own thread
+            rangeState& state{states[index]};
+            const unsigned char* patternBlock{spec.random ? nullptr : Arena.pattern(spec.pattern, static_cast<size_t>(bufferSize))}; // Shared, filled once per process
+
+            if (spec.random && Config.getQueueDepth() > 1) { // This thread generates blocks while the pipeline's thread writes them
+                keystream& engine{spec.final ? state.finalKs : state.ks};
+                blockPipeline pipe(static_cast<size_t>(Config.getQueueDepth()), bufferSize, [&](const unsigned char* data, size_t size, std::uintmax_t offset) {
+                    if (file.writeAt(data, size, offset)) { recordProgress(state, offset + size, size, sweep); return true; }
+                    logMessage(ERROR, "Failed to write to file '" + filePath + "' at offset " + std::to_string(offset));
+                    return false;
+                });
+                forEachBlock(sweepExtents(state, sweep), bufferSize, [&](std::uintmax_t offset, size_t writeSize) {
+                    unsigned char* block{pipe.acquire()};
+                    if (!block) { return false; } // Write stage failed
+                    engine.fill(block, writeSize); // Fills the next free buffer while earlier ones are being written
+                    if (spec.final && Config.isVerify() && !replayVerify) { state.writtenDigest.update(block, writeSize); } // Hashes the verification
+                    pipe.submit(writeSize, offset);
+                    return true;
+                });
+                if (!pipe.finish()) { writeFailed = true; return; }
+                state.position = UINTMAX_MAX; // Range is complete
+                return;
             }
-            file.seekp(offset); // Moves to offset
-            file.write(reinterpret_cast<char*>(randomData.data()), writeSize);  // Writes buffer with retrieved size
-            if (Config.isVerify()) { std::copy(randomData.begin(), randomData.end(), lastRandomData.begin() + offset); } // Copies the verification
-        } else {
-            std::vector<unsigned char> randomData;
-            // Secure shredding mode with multiple patterns (defined and random, plus DoD standards)
-            for (int pass = 0; pass < securePasses; ++pass) {                             
-                // Apply a pre-set pattern
-                std::memcpy(buffer.data(), patterns[pass].data(), bufferSize); // Copy pattern (number 'pass') to buffer9
-                file.seekp(offset); // Move to offset
-                file.write(buffer.data(), writeSize); // Write buffer to file
-
-                // Introduce random pattern for every other pass for additional security
-                if (pass % 2 == 1) {
-                    try {
-                        randomData = rng.generate(writeSize);
-                    } catch (std::runtime_error& e) {
-                        if (!ic.wasFailedUrandomPrinted()) {
-                            logMessage(WARNING, std::string(e.what()));
-                            ic.updateFailedUrandomStatus(true);
-                        }
-#ifndef OPENSSL_FOUND
-                        gen.seed(rd() + pass + offset); // Re-seed with the pass and offset
-                        randomData.resize(writeSize);
-                        std::generate(randomData.begin(), randomData.end(), [&](){ return static_cast<char>(dist(gen)); });
-#else
-                         try { randomData = srng.reseedIfNecessary(writeSize); } catch (...) { throw; }
-#endif 
-                    } catch (...) {
-                        logMessage(ERROR, "An unknown error occurred when generating secure random data");
-#ifndef OPENSSL_FOUND
-                        gen.seed(rd() + pass + offset); // Re-seed with the pass and offset
-                        randomData.resize(writeSize);
-                        std::generate(randomData.begin(), randomData.end(), [&](){ return static_cast<char>(dist(gen)); });
-#else
-                         try { randomData = srng.reseedIfNecessary(writeSize); } catch (...) { throw; }
-#endif                         
-                    }
-                    file.seekp(offset);
-                    file.write(reinterpret_cast<char*>(randomData.data()), writeSize);
+            bool written{forEachBlock(sweepExtents(state, sweep), bufferSize, [&](std::uintmax_t offset, size_t writeSize) { // Sweeps are sequential positioned writes within the range
+                const unsigned char* source{patternBlock};
+                if (spec.random) {
+                    keystream& engine{spec.final ? state.finalKs : state.ks};
+                    engine.fill(state.randomData.data(), writeSize); // Refills the reusable buffer
+                    source = state.randomData.data();
+                    if (spec.final && Config.isVerify() && !replayVerify) { state.writtenDigest.update(source, writeSize); } // Hashes the verification
                 }
-            }
-
-            // DoD-required passes
-            // Pass 1: Overwrite with 0x00
-            std::fill(buffer.begin(), buffer.end(), '\x00'); // Fills buffer
-            file.seekp(offset); // Moves to offset
-            file.write(buffer.data(), writeSize); // Writes buffer to file
-
-            // Pass 2: Overwrite with 0xFF
-            std::fill(buffer.begin(), buffer.end(), '\xFF');
-            file.seekp(offset);
-            file.write(buffer.data(), writeSize);
-
-            // Pass 3: Overwrite with random data
-            try {
-                randomData = rng.generate(writeSize);
-            } catch (std::runtime_error& e) {
-                if (!ic.wasFailedUrandomPrinted()) {
-                    logMessage(WARNING, std::string(e.what()));
-                    ic.updateFailedUrandomStatus(true);
+                if (!file.writeAt(source, writeSize, offset)) {  // Writes buffer with retrieved size
+                    logMessage(ERROR, "Failed to write to file '" + filePath + "' at offset " + std::to_string(offset));
+                    writeFailed = true;
+                    return false;
                 }
-#ifndef OPENSSL_FOUND
-                randomData.resize(writeSize);
-                std::generate(randomData.begin(), randomData.end(), [&](){ return static_cast<char>(dist(gen)); });
-#else
-                try { randomData = srng.reseedIfNecessary(writeSize); } catch (...) { throw; }
-#endif
-            } catch (...) {
-                logMessage(ERROR, "An unknown error occurred when generating secure random data");
-#ifndef OPENSSL_FOUND
-                randomData.resize(writeSize);
-                std::generate(randomData.begin(), randomData.end(), [&](){ return static_cast<char>(dist(gen)); });
-#else
-                try { randomData = srng.reseedIfNecessary(writeSize); } catch (...) { throw; }
-#endif
+                recordProgress(state, offset + writeSize, writeSize, sweep);
+                return true;
+            })};
+            if (written) { state.position = UINTMAX_MAX; } // Range is complete
+        })};
+        if (!finished || writeFailed) { return 1; }
+
+        if (!file.sync()) { logMessage(WARNING, "File '" + filePath + "' failed to synchronize."); } // Barrier so every sweep reaches the media before the next one overwrites it
+            else if (journalKey && sweep + 1 < sweeps.size()) { Journal.checkpoint(*journalKey, {pass - 1, sweep + 1, 0}, fileSize, false); } // Sweep is durable
+        if (sweeps.size() > 1) {
+            if (Config.isInternal()) {
+                char hex[8]{};
+                std::snprintf(hex, sizeof(hex), "0x%02X", spec.pattern);
+                logMessage(INTERNAL, "Completed sweep " + std::to_string(sweep + 1) + "/" + std::to_string(sweeps.size()) + " (" + (spec.random ? std::string("random") : "pattern " + std::string(hex)) + ")");
             }
-            if (Config.isVerify()) { std::copy(randomData.begin(), randomData.end(), lastRandomData.begin() + offset); } // Copies for verification
-            if (Config.isVerify()) { if (lastRandomData.size() < offset + writeSize) {lastRandomData.resize(offset + writeSize); } std::copy(randomData.begin(), randomData.end(), lastRandomData.begin() + offset); }
-            file.seekp(offset);
-            file.write(reinterpret_cast<char*>(randomData.data()), writeSize);
-            if (Config.isInternal()) { logMessage(INTERNAL, "Successfully wrote all DoD passes to block"); }
         }
     }
-    if (Config.isInternal() && !ic.wasBufferPrinted()) { logMessage(INTERNAL, "Blocksize: " + std::to_string(bufferSize)); ic.updateBufferPrintStatus(true); }
     if (Config.isVerify()) {
-        int ret{1}; // Return value (default as "fail")
-        file.flush(); // Ensure all writes are complete
-        file.seekg(0); // Reset to beginning for verification
-
-        std::vector<char> verifyBuffer(bufferSize);
-        bool verificationFailedHere = false; // Initializes boolean that determines if file verification failed
-#ifdef OPENSSL_FOUND
-        ret = verifyWithHash(filePath, lastRandomData, pass); // Config.verify hash
-        if (ret == 2) { verificationFailedHere = true; } // If failed
-        if (ret == 0) { return 0; } // If successful
-#endif
-    if (ret == 1) { // If it failed or OpenSSL is not defined, use fallback verification
-        for (std::uintmax_t offset = 0; offset < fileSize; offset += bufferSize) {
-            std::uintmax_t readSize{std::min(bufferSize, fileSize - offset)}; // Gets size to read
-            file.read(verifyBuffer.data(), readSize); // Reads the control
-
-            // Check if the data is consistent with erasure (e.g., all zeroes after overwrite)
-            if (!std::equal(verifyBuffer.begin(), verifyBuffer.begin() + readSize, lastRandomData.begin() + offset)) {
-                if (Config.isVerbose()) { std::cerr << "Verification failed at offset: " << offset << '\n'; }
-                verificationFailedHere = true; // If it is not equal, fail
-                break;
-            }
+        int ret{}; // Return value (0 = verified, 1 = read failure, 2 = mismatch)
+        if (replayVerify) { // Regenerates and compares block by block, every range in parallel
+            std::atomic<int> worst{0};
+            bool finished{runParallel(states.size(), [&](size_t index) {
+                pooledBuffer verifyBuffer(bufferSize); // Verification only ever holds one block per range (memory is O(block size))
+                int result{verifyWithKeystream(filePath, file, sweepExtents(states[index], sweeps.size() - 1), verifyBuffer, states[index].finalSeed, pass)};
+                if (result != 0) { worst = result; }
+            })};
+            ret = finished ? worst.load() : 1;
+        } else { // Re-hashes the file block by block and compares the combined per-range digests
+            std::vector<std::vector<extent>> ranges;
+            std::vector<std::vector<unsigned char>> digests;
+            for (rangeState& state : states) { ranges.push_back(sweepExtents(state, sweeps.size() - 1)); digests.push_back(state.writtenDigest.finish()); } // Only what this run wrote
+            ret = verifyWithHash(filePath, file, ranges, bufferSize, combineDigests(digests), pass);
         }
+        if (ret != 0) { return 1; } // This will export to the other function for altered behavior
     }
-        if (verificationFailedHere) { return 1; } // This will export to the other function for altered behavior
-    }
+    Stats.addPass(pass, mappedBytes * sweeps.size(), static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - passStart).count()));
     return 0; // Exports success
 }
 
-int hasWritePermission(const fs::path& path) {
+int hasWritePermission(const fs::path& path, const fileInfo& info) {
 #ifdef _WIN32
+    (void)info; // Access is probed with CreateFile instead
     // Windows-specific write permission check using CreateFile
     DWORD dwDesiredAccess{GENERIC_READ | GENERIC_WRITE}; // Set read/write permission as desired
     DWORD dwError{0}; // Initialize error variable
@@ -1128,48 +3433,16 @@ int hasWritePermission(const fs::path& path) {
     wc.updateFailedToGetPerm(true);
     return EXIT_FAILURE;
 #else
-    // POSIX (Linux/macOS) write permission check
-    std::error_code ec{}; // Opens an error code
-    fs::file_status status{fs::status(path, ec)}; // Copies the file information (status) into the file_status struct status (uses error code)
-    if (ec) { // If there is an error retrieving the file status
-        logMessage(ERROR, "Failed to retrieve permissions for '" + path.string() + "': " + ec.message());
-        wc.updateFailedToGetPerm(true);
-        return EXIT_FAILURE;
-    }
-
-    auto perms{status.permissions()}; // Extracts file permissions from the file_status structure status
-
-    struct stat fileStat; // Creates a structure following the stat structure
-    if (stat(path.c_str(), &fileStat) == -1) { // Gets file status (information) and copies it into the fileStat structure
-        logMessage(ERROR, "Failed to get file status for '" + path.string() + "'");
-        wc.updateFailedToGetPerm(true);
-        return EXIT_FAILURE;
-    }
-
-    uid_t fileOwner{fileStat.st_uid}; // Gets file owner
-    gid_t fileGroup{fileStat.st_gid}; // Gets file group
-
-    uid_t currentUser{getuid()}; // Gets current user id
-    gid_t currentGroup{getgid()}; // Gets current group id
-
-    bool isOwner{currentUser == fileOwner}; // Checks if current user is file owner
-    bool isInGroup{currentGroup == fileGroup}; // Checks if current user is in file group
+    // POSIX (Linux/macOS) write permission check (uses the mode and ownership captured by the traversal's stat)
+    const callerCredentials& caller{callerCredentials::current()}; // Read once per run
+    accessClass cls{classOf(static_cast<uid_t>(info.uid), static_cast<gid_t>(info.gid), caller.uid, caller.gid)}; // Owner, else group, else other
+    unsigned granted{permittedBits(static_cast<mode_t>(info.mode), cls)}; // rwx bits of that class
 
     wc.updateFailedToGetPerm(false); // By default, no permissions
+    wc.updateWritePerm((granted & 2) != 0);
+    wc.updateReadPerm((granted & 4) != 0);
 
-    // Iterates through perms looking for the respective write permissions
-    if (isOwner) { // Checks for owner write, if owner
-        wc.updateWritePerm((perms & fs::perms::owner_write) != fs::perms::none);
-        wc.updateReadPerm((perms & fs::perms::owner_read) != fs::perms::none);
-    } else if (isInGroup) { // Checks for group write, if in group
-        wc.updateWritePerm((perms & fs::perms::group_write) != fs::perms::none);
-        wc.updateReadPerm((perms & fs::perms::group_read) != fs::perms::none);
-    } else { // Checks for others write, if neither owner or in group
-        wc.updateWritePerm((perms & fs::perms::others_write) != fs::perms::none);
-        wc.updateReadPerm((perms & fs::perms::others_read) != fs::perms::none);
-    }
-
-    if (geteuid() == 0) { wc.updateWritePerm(true); wc.updateReadPerm(true); } // If root, bypass this check
+    if (caller.euid == 0) { wc.updateWritePerm(true); wc.updateReadPerm(true); } // If root, bypass this check
     if (!wc.isWritePerm()) { // In case the checks fail, yet the user has write permissions
         if (access(path.c_str(), W_OK) == 0) {
             wc.updateWritePerm(true);
@@ -1206,28 +3479,26 @@ bool changePermissions(const std::string &filePath) {
         HANDLE fileHandle{CreateFile(filePath.c_str(), (GENERIC_READ | GENERIC_WRITE), 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL)};
         if (fileHandle != INVALID_HANDLE_VALUE) {
             CloseHandle(fileHandle);
-            logMessage(INFO, "Write access verified on file '" + filePath + "'");
+            if (isLogged(INFO)) { logMessage(INFO, "Write access verified on file '" + filePath + "'"); }
             return true;
         }
 #else
         struct stat fileStat; // Creates a stat structure for the file
-        if (stat(filePath.c_str(), &fileStat) == 0) { // If it successfully gets the stats
+        bool haveStat{stat(filePath.c_str(), &fileStat) == 0};
+        if (haveStat) { // If it successfully gets the stats
             isExecutable = (fileStat.st_mode & S_IXUSR) || (fileStat.st_mode & S_IXGRP); // Checks for owner or group execution privileges and sets the boolean accordingly
         } else {
             logMessage(WARNING, "Failed to obtain stats on file '" + filePath + "'");
         }
 
         // On POSIX systems, ensure full permissions
-        int ret{}; // To store the exit result
-
-        if (isExecutable) { // Determines whether to change the permissions with execute or not
-            ret = chmod(filePath.c_str(), S_IRWXU | S_IRWXG | S_IRWXO); // rwxrwxrwx
-        } else {
-            ret = chmod(filePath.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH); // rw-rw-rw-
-        }
+        mode_t wanted{isExecutable ? static_cast<mode_t>(S_IRWXU | S_IRWXG | S_IRWXO) // rwxrwxrwx
+                                   : static_cast<mode_t>(S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH)}; // rw-rw-rw-
+        int ret{haveStat ? (changeMode(AT_FDCWD, filePath.c_str(), fileStat.st_mode, wanted) < 0 ? -1 : 0) // No chmod if already set
+                         : chmod(filePath.c_str(), wanted)}; // To store the exit result
 
         if (ret == 0) { // Based on exit value of chmod
-            logMessage(INFO, "Permissions updated on file '" + filePath + "'");
+            if (isLogged(INFO)) { logMessage(INFO, "Permissions updated on file '" + filePath + "'"); }
         } else {
             logMessage(ERROR, "Permissions failed to change on file '" + filePath + "'");
             return false;
@@ -1237,10 +3508,10 @@ bool changePermissions(const std::string &filePath) {
 #ifndef _WIN32
         // Extended attributes are system-dependent, handled here if supported
         if (system(("xattr -c \"" + filePath + "\" 2>/dev/null").c_str()) == 0) { // Mac / Linux
-            logMessage(INFO, "Extended attributes cleared on file '" + filePath + "'");
+            if (isLogged(INFO)) { logMessage(INFO, "Extended attributes cleared on file '" + filePath + "'"); }
         } 
         else if (system(("attr -r \"\" \"" + filePath + "\" 2>/dev/null").c_str()) == 0) { // Linux
-            logMessage(INFO, "Extended attributes cleared on file '" + filePath + "'");
+            if (isLogged(INFO)) { logMessage(INFO, "Extended attributes cleared on file '" + filePath + "'"); }
         } 
         else { // no
             logMessage(WARNING, "Failed to clear extended attributes on file '" + filePath + "'");
@@ -1248,7 +3519,7 @@ bool changePermissions(const std::string &filePath) {
 #endif
     bool successOne{false};
         if (access(filePath.c_str(), W_OK) == 0) { // If the file has write permissions
-            logMessage(INFO, "Write access verified on file '" + filePath + "'");
+            if (isLogged(INFO)) { logMessage(INFO, "Write access verified on file '" + filePath + "'"); }
             wc.updateWritePerm(true);
             successOne = true;
         }
@@ -1266,6 +3537,253 @@ bool changePermissions(const std::string &filePath) {
     return false;
 }
 
+void runBenchmark() { // Builds synthetic corpora and times recursive shreds of them across a sweep of settings
+    struct benchCorpus {
+        std::string name;
+        int files; // Files in the corpus
+        std::uintmax_t fileSize; // Apparent size of each file
+        int depth; // Directory levels the files are spread over (1 = flat)
+        bool sparse; // Only the first and last MiB hold data
+    };
+    struct benchCase {
+        std::string name;
+        std::uintmax_t blockSize; // 0 = getOptimalBlockSize()
+        int passes;
+        bool secure;
+        bool verify;
+        rngBackend rng;
+        int jobs;
+    };
+
+    const std::uintmax_t MiB{1024 * 1024};
+    const std::vector<benchCorpus> corpora{
+        {"tiny", 2000, 4096, 1, false},        // Metadata and per-file overhead
+        {"huge", 2, 128 * MiB, 1, false},      // Streaming throughput
+        {"sparse", 4, 64 * MiB, 1, true},      // Holes are overwritten in full
+        {"deep", 256, 16 * 1024, 32, false},   // Traversal cost
+    };
+    const benchCase base{"baseline", 0, 1, false, true, RNG_CHACHA, 1};
+    std::vector<benchCase> cases{base};
+    for (std::uintmax_t kib : {64, 1024, 4096, 16384}) { benchCase c{base}; c.name = "block=" + std::to_string(kib) + "K"; c.blockSize = kib * 1024; cases.push_back(c); }
+    { benchCase c{base}; c.name = "passes=3"; c.passes = 3; cases.push_back(c); }
+    { benchCase c{base}; c.name = "secure"; c.secure = true; cases.push_back(c); }
+    { benchCase c{base}; c.name = "no-verify"; c.verify = false; cases.push_back(c); }
+    { benchCase c{base}; c.name = "rng=kernel"; c.rng = RNG_KERNEL; cases.push_back(c); }
+    if (isOpenSSL) { benchCase c{base}; c.name = "rng=aesctr"; c.rng = RNG_AESCTR; cases.push_back(c); }
+    for (int jobs : {2, 4}) { benchCase c{base}; c.name = "jobs=" + std::to_string(jobs); c.jobs = jobs; cases.push_back(c); }
+
+    fs::path directory{Config.getBenchmarkDir()};
+    if (directory.empty()) { directory = fs::is_directory("/dev/shm") ? fs::path("/dev/shm") : fs::temp_directory_path(); } // RAM-backed when available
+    fs::path root{directory / ("shred-bench-" + generateRandomFileName(8))};
+    std::error_code ec{};
+    if (!fs::create_directories(root, ec) || ec) { errorExit(1, "Failed to create benchmark directory '" + root.string() + "'"); }
+#ifdef __linux__
+    struct statfs fsInfo;
+    bool tmpfs{statfs(root.c_str(), &fsInfo) == 0 && fsInfo.f_type == 0x01021994}; // TMPFS_MAGIC
+    std::cout << "Benchmark directory: " << root.string() << (tmpfs ? " (tmpfs: CPU-side costs only)" : " (not tmpfs: results include device speed)") << "\n" << std::endl;
+#else
+    std::cout << "Benchmark directory: " << root.string() << "\n" << std::endl;
+#endif
+
+    std::vector<char> chunk(MiB, '\x5A'); // File contents are irrelevant to the shredder
+    auto buildCorpus = [&](const benchCorpus& corpus) { // Returns the number of bytes the corpus occupies (apparent size)
+        fs::path level{root};
+        for (int f = 0; f < corpus.files; ++f) {
+            if (corpus.depth > 1 && f % std::max(1, corpus.files / corpus.depth) == 0) { level /= "d" + std::to_string(f); fs::create_directory(level); } // Next level down
+            std::ofstream out(level / ("f" + std::to_string(f)), std::ios::binary | std::ios::trunc);
+            if (corpus.sparse) { // First and last MiB only; the middle stays a hole
+                out.write(chunk.data(), static_cast<std::streamsize>(MiB));
+                out.seekp(static_cast<std::streamoff>(corpus.fileSize - MiB));
+                out.write(chunk.data(), static_cast<std::streamsize>(MiB));
+            } else {
+                for (std::uintmax_t written = 0; written < corpus.fileSize; written += MiB) { out.write(chunk.data(), static_cast<std::streamsize>(std::min<std::uintmax_t>(MiB, corpus.fileSize - written))); }
+            }
+            if (!out) { errorExit(1, "Failed to build benchmark corpus in '" + root.string() + "'"); }
+        }
+        return static_cast<std::uintmax_t>(corpus.files) * corpus.fileSize;
+    };
+
+    Config.updateFlag("recursive", true);
+    Config.updateFlag("keep_files", false);
+    Config.updateFlag("dry_run", false);
+    std::cout << std::left << std::setw(8) << "Corpus" << std::setw(14) << "Case" << std::right << std::setw(12) << "MB/s" << std::setw(12) << "files/s" << std::setw(10) << "seconds" << std::endl;
+    for (const benchCorpus& corpus : corpora) {
+        for (const benchCase& c : cases) {
+            Config.updateBlockSize(c.blockSize);
+            Config.updateCount(c.passes);
+            Config.updateFlag("secure_mode", c.secure);
+            Config.updateFlag("verify", c.verify);
+            Config.rng = c.rng;
+            Config.updateJobs(c.jobs);
+
+            std::uintmax_t bytes{buildCorpus(corpus)}; // Rebuilt for every case (not timed)
+            auto begin{std::chrono::steady_clock::now()};
+            if (c.jobs > 1) { Pool = std::make_unique<shredPool>(c.jobs); }
+            processPath(root);
+            Pool.reset();
+            syncDirectories();
+            double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()};
+            fs::remove_all(root, ec); // Empty subdirectories left behind by the recursive shred (not reported in benchmark runs)
+            fs::create_directories(root, ec);
+
+            double megabytes{static_cast<double>(bytes) * c.passes / 1e6}; // Logical bytes overwritten (every pass of every file)
+            Logger.flush(); // Warnings from this run come before its row
+            std::cout << std::left << std::setw(8) << corpus.name << std::setw(14) << c.name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << (seconds > 0 ? megabytes / seconds : 0.0) << std::setw(12) << (seconds > 0 ? corpus.files / seconds : 0.0)
+                      << std::setprecision(3) << std::setw(10) << seconds << std::endl;
+        }
+    }
+    fs::remove_all(root, ec);
+}
+
+int preallocateFile(const fs::path& path, std::uintmax_t size) { // Creates a file with 'size' bytes allocated (0 = done, 1 = out of space, 2 = other failure)
+#ifdef _WIN32
+    HANDLE handle{CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL)};
+    if (handle == INVALID_HANDLE_VALUE) { return GetLastError() == ERROR_DISK_FULL ? 1 : 2; }
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    bool ok{SetFilePointerEx(handle, end, NULL, FILE_BEGIN) && SetEndOfFile(handle)}; // NTFS allocates the clusters up front
+    DWORD error{ok ? 0 : GetLastError()};
+    CloseHandle(handle);
+    if (ok) { return 0; }
+    std::error_code ec;
+    fs::remove(path, ec);
+    return error == ERROR_DISK_FULL ? 1 : 2;
+#else
+    int fd{open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600)};
+    if (fd == -1) { return (errno == ENOSPC || errno == EDQUOT) ? 1 : 2; }
+    int error{0};
+#ifdef __linux__
+    if (fallocate(fd, 0, 0, static_cast<off_t>(size)) != 0) { // Reserves the blocks without writing them
+        error = errno;
+        if (error == EOPNOTSUPP) { error = posix_fallocate(fd, 0, static_cast<off_t>(size)); } // File systems without fallocate (glibc writes instead)
+    }
+#elif defined(__APPLE__)
+    fstore_t store{F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(size), 0};
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) { // Contiguous first, then any free blocks
+        store.fst_flags = F_ALLOCATEALL;
+        if (fcntl(fd, F_PREALLOCATE, &store) == -1) { error = errno; }
+    }
+    if (error == 0 && ftruncate(fd, static_cast<off_t>(size)) != 0) { error = errno; }
+#else
+    error = posix_fallocate(fd, 0, static_cast<off_t>(size));
+#endif
+    close(fd);
+    if (error == 0) { return 0; }
+    unlink(path.c_str()); // Partial allocations are given back before a smaller size is tried
+    return (error == ENOSPC || error == EDQUOT) ? 1 : 2;
+#endif
+}
+
+std::uintmax_t writeTailFile(const fs::path& path) { // Writes zeros to a new file until the volume is full; returns the bytes written (0 = nothing fit, file removed)
+    std::vector<char> zeros(64 * 1024);
+    std::uintmax_t written{};
+#ifdef _WIN32
+    HANDLE handle{CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL)};
+    if (handle == INVALID_HANDLE_VALUE) { return 0; }
+    for (DWORD chunk = static_cast<DWORD>(zeros.size()); chunk > 0; chunk /= 2) { // Smaller writes once a full chunk no longer fits
+        DWORD done{};
+        while (WriteFile(handle, zeros.data(), chunk, &done, NULL) && done > 0) { written += done; }
+    }
+    FlushFileBuffers(handle);
+    CloseHandle(handle);
+#else
+    int fd{open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600)};
+    if (fd == -1) { return 0; }
+    for (size_t chunk = zeros.size(); chunk > 0; chunk /= 2) { // Buffered, so the last blocks are allocated too (a short write marks the end)
+        ssize_t done{};
+        while ((done = write(fd, zeros.data(), chunk)) > 0 || (done == -1 && errno == EINTR)) {
+            if (done > 0) { written += static_cast<std::uintmax_t>(done); }
+        }
+    }
+    if (fsync(fd) != 0) { written = 0; } // Delayed allocation can still run out of space here
+    close(fd);
+#endif
+    if (written == 0) {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+    return written;
+}
+
+void wipeFreeSpace(const fs::path& mount) { // Fills the free space of a volume with preallocated files and shreds them through the normal pass engine
+    const std::uintmax_t MiB{1024 * 1024};
+    const std::uintmax_t fillSize{1024 * MiB}; // Fill files are large enough for parallel ranges, and many enough for -j
+    const std::uintmax_t minFill{64 * 1024}; // Smallest file tried once the volume reports it is full
+    std::error_code ec{};
+    fs::space_info space{fs::space(mount, ec)};
+    if (ec || !fs::is_directory(mount, ec)) {
+        logMessage(ERROR, "'" + mount.string() + "' is not a mounted directory (free space can't be queried).");
+        Program.updateErrorStatus();
+        return;
+    }
+    if (Config.isDry_run()) {
+        logMessage(DRY_RUN, "Free space of '" + mount.string() + "' (" + std::to_string(space.available / MiB) + " MiB) would be wiped.");
+        return;
+    }
+
+    if (Pool) { Pool->wait(); } // Space freed by the files shredded before this is wiped too
+    fs::path root{mount / (".shred-wipe-" + generateRandomFileName(8))}; // Hidden, so it is obvious what to remove after a crash
+    if (!fs::create_directory(root, ec) || ec) {
+        logMessage(ERROR, "Failed to create fill directory '" + root.string() + "'");
+        Program.updateErrorStatus();
+        return;
+    }
+    if (isLogged(INFO)) { logMessage(INFO, "Filling " + std::to_string(space.available / MiB) + " MiB of free space on '" + mount.string() + "' under '" + root.string() + "'"); }
+
+    // Preallocates fill files until the volume is full, halving the size on ENOSPC so the tail is filled as well
+    std::vector<fs::path> fills;
+    std::uintmax_t filled{};
+    std::uintmax_t size{fillSize};
+    auto allocStart{std::chrono::steady_clock::now()};
+    while (size >= minFill) {
+        fs::path fill{root / ("fill" + std::to_string(fills.size()))};
+        int result{preallocateFile(fill, size)};
+        if (result == 0) { fills.push_back(fill); filled += size; continue; }
+        if (result == 2) {
+            logMessage(ERROR, "Failed to allocate fill file '" + fill.string() + "'");
+            Program.updateErrorStatus();
+            break;
+        }
+        size /= 2; // Out of space at this size
+    }
+    if (size < minFill) { // The last, smaller-than-minFill gap is filled by plain writes
+        fs::path tail{root / ("fill" + std::to_string(fills.size()))};
+        std::uintmax_t tailSize{writeTailFile(tail)};
+        if (tailSize > 0) { fills.push_back(tail); filled += tailSize; }
+    }
+    std::uintmax_t leftover{fs::space(mount, ec).free}; // Includes blocks the file system keeps back from every writer (e.g., ext4's reserved clusters)
+    if (!ec && leftover > 0) { logMessage(WARNING, std::to_string(leftover / 1024) + " KiB of free space on '" + mount.string() + "' could not be filled and is not wiped."); }
+    double allocSeconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - allocStart).count()};
+    if (isLogged(INFO)) { logMessage(INFO, "Allocated " + std::to_string(filled / MiB) + " MiB in " + std::to_string(fills.size()) + " fill files (" + std::to_string(allocSeconds) + " seconds)."); }
+
+    std::uint64_t writtenBefore{Stats.overwrittenBytes()};
+    auto begin{std::chrono::steady_clock::now()};
+    for (const fs::path& fill : fills) { dispatchFile(fill, fileInfo{}); } // Same passes, patterns, verification and unlink as any other file
+    if (Pool) { Pool->wait(); }
+    syncDirectories();
+    double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()};
+    std::uint64_t written{Stats.overwrittenBytes() - writtenBefore}; // What the passes actually wrote, not what they were asked to
+
+    if (fs::is_empty(root, ec) && fs::remove(root, ec)) {
+        if (isLogged(INFO)) { logMessage(INFO, "Fill directory '" + root.string() + "' removed."); }
+    } else {
+        logMessage(WARNING, "Fill directory '" + root.string() + "' still holds files that could not be shredded.");
+        Program.updateErrorStatus();
+    }
+
+    if (written < static_cast<std::uint64_t>(filled) * Config.getOverwriteCount()) {
+        logMessage(ERROR, "Only " + std::to_string(written / MiB) + " of " + std::to_string(filled * Config.getOverwriteCount() / MiB) + " MiB were written to the fill files on '" + mount.string() + "'; free space was not fully wiped.");
+        Program.updateErrorStatus();
+    }
+
+    std::ostringstream report;
+    report << "Wiped " << filled / MiB << " MiB of free space on '" << mount.string() << "' in " << fills.size() << " files, "
+           << Config.getOverwriteCount() << (Config.getOverwriteCount() == 1 ? " pass" : " passes") << " (" << written / MiB << " MiB written): " << std::fixed << std::setprecision(3) << seconds << " seconds ("
+           << std::setprecision(1) << (seconds > 0 ? static_cast<double>(written) / MiB / seconds : 0.0) << " MiB/s)\n";
+    Logger.raw(report.str());
+}
+
 void help(char* argv[]) { // The print help functon (At bottom due to size and lack of functionality)
     std::cerr << "NAME" << std::endl;
     std::cerr << "    " << argv[0] << " - Securely overwrite and remove files\n" << std::endl;
@@ -1280,9 +3798,13 @@ void help(char* argv[]) { // The print help functon (At bottom due to size and l
     std::cerr << "    This tool almost conforms to DoD 5220.22-M when the '--secure' flag is used without the '--no-verify' flag, and" << std::endl;
     std::cerr << "    this tool does not conform due to the unnecessary complexity (which enhances the security of the shred).\n" << std::endl;
 #ifdef OPENSSL_FOUND
-    std::cerr << "    Since this program was compiled with OpenSSL, the file verification function uses SHA256 hashing," << std::endl;
-    std::cerr << "    which is more efficient, secure, and accurate for file shredding confirmation.\n" << std::endl;
+    std::cerr << "    Since this program was compiled with OpenSSL, the file verification function uses SHA256 hashing by default," << std::endl;
+    std::cerr << "    which runs on the CPU's SHA instructions (SHA-NI, ARMv8 SHA) where they are available.\n" << std::endl;
 #endif
+    std::cerr << "    '--hash' picks the digest used when a pass is hashed: sha256, blake3 (built in, eight chunks per step), or" << std::endl;
+    std::cerr << "    xxh64 (built in and several times faster, but not cryptographic; fine for checking what was written).\n" << std::endl;
+    std::cerr << "    Verification streams the file back in blocks, so it needs no more memory than one block. Keystream passes" << std::endl;
+    std::cerr << "    ('--rng=chacha' or '--rng=aesctr') are regenerated from their seed and compared, kernel passes are hashed.\n" << std::endl;
     std::cerr << "    When deleting the file after shredding, metadata is stripped and the file is moved, renamed, and dereferenced." << std::endl;
     std::cerr << "    For this reason, shredding with the --keep-files flag is around 9x faster than without. If you are not using a" << std::endl;
     std::cerr << "    journaling operating system, consider this flag and then use a utility like `rm` to dereference (unlink) it.\n" << std::endl;
@@ -1301,7 +3823,27 @@ void help(char* argv[]) { // The print help functon (At bottom due to size and l
     std::cerr << "    -s <secure mode>      Enable secure shredding with randomization (slower)" << std::endl;
     std::cerr << "    -d <dry run>          Show what would be shredded without actual processing" << std::endl;
     std::cerr << "    -c <no verification>  Skip post-shredding verification (faster)" << std::endl;
-    std::cerr << "    -f <force>            Force delete the file if there is no write permission\n" << std::endl;
+    std::cerr << "    -f <force>            Force delete the file if there is no write permission" << std::endl;
+    std::cerr << "    --rng=<engine>        Random data engine: kernel, chacha (default), or aesctr" << std::endl;
+    std::cerr << "    --hash=<digest>       Digest for hashed verification: sha256, blake3, or xxh64" << std::endl;
+    std::cerr << "    --block-size=<size>   Set the I/O transfer size (default: determined per file)" << std::endl;
+    std::cerr << "    --buffered            Overwrite through the page cache instead of direct I/O" << std::endl;
+    std::cerr << "    -j, --jobs=<num>      Shred up to <num> files concurrently (default: 1)" << std::endl;
+    std::cerr << "    --device-jobs=<num>   Limit concurrent files per device (default: 1 on spinning disks)" << std::endl;
+    std::cerr << "    --file-threads=<num>  Overwrite one file in <num> parallel ranges (default: auto for large files)" << std::endl;
+    std::cerr << "    --queue-depth=<num>   Blocks in flight between RNG, write, and verify stages (default: 3)" << std::endl;
+    std::cerr << "    --sparse              Overwrite only allocated extents of sparse files (holes are skipped)" << std::endl;
+    std::cerr << "    --from-file=<file>    Also shred the NUL-delimited paths listed in <file> (e.g., from 'find -print0')" << std::endl;
+    std::cerr << "    --from-stdin          Also shred the NUL-delimited paths read from standard input" << std::endl;
+    std::cerr << "    --log-file=<path>     Append every message (INFO included) to <path> as JSON lines" << std::endl;
+    std::cerr << "    --journal=<path>      Record finished files and pass progress in <path>" << std::endl;
+    std::cerr << "    --resume              Skip the work recorded in the journal and continue where it stopped" << std::endl;
+    std::cerr << "    --wipe-free-space=<mount>" << std::endl;
+    std::cerr << "                          Overwrite the free space of the volume mounted at <mount>" << std::endl;
+    std::cerr << "    --stats               Report throughput and latency statistics (JSON) at exit" << std::endl;
+    std::cerr << "    --stats-file=<path>   Write the statistics report to <path> (CSV if it ends in .csv)" << std::endl;
+    std::cerr << "    --benchmark[=<dir>]   Time the shredder on synthetic files across a sweep of settings" << std::endl;
+    std::cerr << "    --self-test           Run the built-in known-answer checks (journal recovery) and exit\n" << std::endl;
 
     std::cerr << "DESCRIPTION OF OPTIONS" << std::endl;
     std::cerr << "    -h, --help <help>" << std::endl;
@@ -1356,6 +3898,60 @@ void help(char* argv[]) { // The print help functon (At bottom due to size and l
     std::cerr << "        Will attempt to change file permissions and remove extended attributes to attempt to delete files which" << std::endl;
     std::cerr << "        do not currently have effective write permission, use this for stubborn files.\n" << std::endl;
 
+    std::cerr << "    -j <num>, --jobs=<num>" << std::endl;
+    std::cerr << "        Shreds up to <num> independent files at the same time with a bounded worker pool. Each file is still" << std::endl;
+    std::cerr << "        handled by one worker from start to finish; directories are removed once all of their files are done.\n" << std::endl;
+
+    std::cerr << "    --device-jobs=<num>" << std::endl;
+    std::cerr << "        Limits how many files on the same device are shredded at once. By default spinning disks (Linux" << std::endl;
+    std::cerr << "        'rotational' devices) take one file at a time so concurrent passes don't thrash the heads.\n" << std::endl;
+
+    std::cerr << "    --file-threads=<num>" << std::endl;
+    std::cerr << "        Splits each file into <num> block-aligned ranges that are overwritten by separate threads, each with its own" << std::endl;
+    std::cerr << "        random stream, with a barrier between sweeps. By default files of 512 MiB or more on non-rotational devices" << std::endl;
+    std::cerr << "        are split (at least 256 MiB per range, up to 8 ranges) using the cores not already taken by '-j'.\n" << std::endl;
+
+    std::cerr << "    --queue-depth=<num>" << std::endl;
+    std::cerr << "        Number of blocks in flight in each range's pipeline. Random data is generated into one buffer while earlier" << std::endl;
+    std::cerr << "        buffers are written, and verification reads ahead while earlier blocks are compared. 1 disables pipelining.\n" << std::endl;
+
+    std::cerr << "    --sparse" << std::endl;
+    std::cerr << "        Queries the file's allocated extents (SEEK_DATA/SEEK_HOLE, or FSCTL_QUERY_ALLOCATED_RANGES on Windows) and" << std::endl;
+    std::cerr << "        overwrites and verifies only those, so holes in VM images or core dumps are not filled in. The map is queried" << std::endl;
+    std::cerr << "        again for every pass. File systems that can't report holes are overwritten in full.\n" << std::endl;
+
+    std::cerr << "    --from-file=<file>, --from-stdin" << std::endl;
+    std::cerr << "        Reads paths separated by NUL bytes (as written by 'find -print0') and shreds each one as it is read, after" << std::endl;
+    std::cerr << "        any paths given on the command line. One process can work through an unbounded list in constant memory;" << std::endl;
+    std::cerr << "        with '-j' the reader waits whenever the worker queue is full.\n" << std::endl;
+
+    std::cerr << "    --log-file=<path>" << std::endl;
+    std::cerr << "        Appends every message, whether or not it is printed (INFO included), to <path> as one JSON object per line" << std::endl;
+    std::cerr << "        with its time, level, and thread. Console and file output are written by a background thread.\n" << std::endl;
+
+    std::cerr << "    --journal=<path>, --resume" << std::endl;
+    std::cerr << "        Records every finished file in <path>, and for files of 64 MiB or more each completed pass and sweep plus a" << std::endl;
+    std::cerr << "        watermark every 1 GiB (taken after a sync, so it never runs ahead of the media). Records are written in" << std::endl;
+    std::cerr << "        batches, about one sync per second. After a crash or Ctrl-C, rerun the same command with '--resume': finished" << std::endl;
+    std::cerr << "        files are skipped and large files continue from their watermark (verification then covers what the resumed" << std::endl;
+    std::cerr << "        run wrote). Without '--resume' the journal is started over.\n" << std::endl;
+
+    std::cerr << "    --wipe-free-space=<mount>" << std::endl;
+    std::cerr << "        Sanitizes space left behind by files deleted with other tools. The free space of <mount> is filled with 1 GiB" << std::endl;
+    std::cerr << "        preallocated files (fallocate; smaller ones once the volume is full, down to 64 KiB), which are then shredded" << std::endl;
+    std::cerr << "        like any other file (passes, '-s', verification, '-j' and parallel ranges all apply) and removed. The volume is" << std::endl;
+    std::cerr << "        full while this runs. If the run is killed, delete the hidden '.shred-wipe-*' directory it leaves behind.\n" << std::endl;
+
+    std::cerr << "    --stats, --stats-file=<path>" << std::endl;
+    std::cerr << "        Times every stage (random generation, write, sync, verification read, hashing, unlink) and counts bytes," << std::endl;
+    std::cerr << "        system calls, and buffer allocations. A rate line is printed every 2 seconds and a report at exit: per-phase," << std::endl;
+    std::cerr << "        per-pass throughput and a per-file latency histogram. Stage times are summed across threads.\n" << std::endl;
+
+    std::cerr << "    --benchmark[=<dir>]" << std::endl;
+    std::cerr << "        Builds synthetic corpora (many tiny files, a few huge files, sparse files, and a deep tree) in <dir> (default:" << std::endl;
+    std::cerr << "        /dev/shm, so device speed is left out) and shreds each one while varying block size, pass count, secure mode," << std::endl;
+    std::cerr << "        verification, RNG backend, and jobs. Prints MB/s and files/s per run; file arguments are ignored.\n" << std::endl;
+
     std::cerr << "EXAMPLES" << std::endl;
     std::cerr << "    " << argv[0] << " -n5 --force --recursive -vs file1.txt file2.txt directory1" << std::endl;
     std::cerr << "        Forcefully overwrites 'file1.txt' and 'file2.txt' with 5 passes, recursively handles 'directory1', and uses secure" << std::endl;
@@ -1364,6 +3960,15 @@ void help(char* argv[]) { // The print help functon (At bottom due to size and l
     std::cerr << "    " << argv[0] << " --dry file1.txt file2.txt" << std::endl;
     std::cerr << "        Performs a dry run to show what would be shredded without actual deletion.\n" << std::endl;
 
+    std::cerr << "    find /srv/cache -name '*.tmp' -print0 | " << argv[0] << " -j8 --from-stdin" << std::endl;
+    std::cerr << "        Shreds every matching file in one process, eight files at a time.\n" << std::endl;
+
+    std::cerr << "    " << argv[0] << " -r --journal=wipe.journal --resume /mnt/archive" << std::endl;
+    std::cerr << "        Continues an interrupted '-r --journal=wipe.journal /mnt/archive' run from where it stopped.\n" << std::endl;
+
+    std::cerr << "    " << argv[0] << " -j4 --wipe-free-space=/home" << std::endl;
+    std::cerr << "        Overwrites the unused space of the volume mounted at '/home', four fill files at a time.\n" << std::endl;
+
     std::cerr << "EXIT STATUS" << std::endl;
     std::cerr << "    The " << argv[0] << " utility will exit 0 on success, 1 on error, and 2 on user-defined exit (i.e., help, version, copyright, etc.)." << std::endl;
 
@@ -1388,6 +3993,22 @@ void shortHelp(char* argv[]) {
     std::cerr << "    -d, --dry                         Show what would be shredded without actual processing" << std::endl;
     std::cerr << "    -c, --no-verify                   Skip post-shredding verification (faster)" << std::endl;
     std::cerr << "    -f, --force                       Force delete the file if there is no write permission" << std::endl; 
+    std::cerr << "    --rng=<kernel|chacha|aesctr>      Random data engine (default: chacha)" << std::endl;
+    std::cerr << "    --hash=<sha256|blake3|xxh64>      Verification digest for kernel passes (default: " << (isOpenSSL ? "sha256" : "blake3") << ")" << std::endl;
+    std::cerr << "    --block-size=<size>               Set the I/O transfer size (default: auto, ~4 MiB)" << std::endl;
+    std::cerr << "    --buffered                        Use buffered I/O instead of direct I/O" << std::endl;
+    std::cerr << "    -j, --jobs=<num>                  Shred <num> files concurrently (default: 1)" << std::endl;
+    std::cerr << "    --device-jobs=<num>               Concurrent files per device (default: auto)" << std::endl;
+    std::cerr << "    --file-threads=<num>              Parallel ranges per file (default: auto)" << std::endl;
+    std::cerr << "    --queue-depth=<num>               Blocks in flight per range (default: 3)" << std::endl;
+    std::cerr << "    --sparse                          Skip holes (overwrite allocated extents only)" << std::endl;
+    std::cerr << "    --from-file=<file>, --from-stdin  Shred NUL-delimited paths from a file or stdin" << std::endl;
+    std::cerr << "    --log-file=<path>                 Write a structured (JSON lines) log to <path>" << std::endl;
+    std::cerr << "    --journal=<path>, --resume        Record progress and resume interrupted runs" << std::endl;
+    std::cerr << "    --wipe-free-space=<mount>         Overwrite the free space of a volume" << std::endl;
+    std::cerr << "    --stats, --stats-file=<path>      Report throughput/latency statistics (JSON or CSV)" << std::endl;
+    std::cerr << "    --benchmark[=<dir>]               Benchmark the shredder on synthetic files" << std::endl;
+    std::cerr << "    --self-test                       Run the built-in known-answer checks and exit" << std::endl;
 
     errorExit(2); // Exits
 }
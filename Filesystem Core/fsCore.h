@@ -0,0 +1,296 @@
+/*
+  Shared filesystem core for the shredder and the file mode scripts.
+  Copyright (C) 2024  Aristotle Daskaleas
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+// Header-only POSIX layer used by shred (File and Directory Shredder) and mp/fp/rp/wp/xp/np (File Mode Scripts):
+//  - callerCredentials: the process' real and effective ids, read once per run
+//  - classOf() / permittedBits(): which owner/group/other class a file puts the caller in, and what that class may do
+//  - changeMode(): fd-relative chmod that is skipped when the bits are already right
+//  - walkTree(): a directory walker with a worker pool, one open/fstat per directory, d_type classification and one
+//    fstatat() per regular file, handing each file to a visitor together with its stat
+//  - walkCounters: relaxed atomic counters of what the walker did (for --stats style reports)
+
+#ifndef FILESYSTEM_CORE_H
+#define FILESYSTEM_CORE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+
+// Real and effective ids of the running process, read once.
+struct callerCredentials {
+    uid_t uid;
+    gid_t gid;
+    uid_t euid;
+    gid_t egid;
+
+    static const callerCredentials &current() {
+        static const callerCredentials credentials{getuid(), getgid(), geteuid(), getegid()};
+        return credentials;
+    }
+};
+
+// Permission classes of a mode, as bits so that sets of classes can be combined.
+enum accessClass : unsigned { classOwner = 1, classGroup = 2, classOther = 4 };
+
+// The class a file with this owner and group puts the given user in (owner, else group, else other).
+inline accessClass classOf(uid_t fileOwner, gid_t fileGroup, uid_t uid, gid_t gid) {
+    return uid == fileOwner ? classOwner : (gid == fileGroup ? classGroup : classOther);
+}
+
+// The rwx bits (r = 4, w = 2, x = 1) a mode grants to one class.
+inline unsigned permittedBits(mode_t mode, accessClass cls) {
+    return (mode >> (cls == classOwner ? 6 : (cls == classGroup ? 3 : 0))) & 7;
+}
+
+// What the walker (and changeMode()) did; relaxed atomics, so any worker thread records without locking.
+struct walkCounters {
+    std::atomic<std::uint64_t> directories{0}; // Directories opened
+    std::atomic<std::uint64_t> reused{0}; // Directories whose listing came from the visitor instead of readdir()
+    std::atomic<std::uint64_t> entries{0}; // Directory entries read
+    std::atomic<std::uint64_t> files{0}; // Regular files handed to the visitor
+    std::atomic<std::uint64_t> syscalls{0}; // open/fstat/fstatat/fchmodat/close (getdents64 counted once per directory)
+    std::atomic<std::uint64_t> modeChanges{0}; // fchmodat() calls issued
+    std::atomic<std::uint64_t> modesKept{0}; // Modes that were already right, so no fchmodat() was needed
+    std::atomic<std::uint64_t> errors{0}; // Failures reported to the visitor
+
+    void add(std::atomic<std::uint64_t> &counter, std::uint64_t count = 1) {
+        counter.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // One-line summary, e.g. for a tool's --stats flag.
+    std::string summary() const {
+        auto value = [](const std::atomic<std::uint64_t> &counter) {
+            return std::to_string(counter.load(std::memory_order_relaxed));
+        };
+        return "directories " + value(directories) + " (reused " + value(reused) + "), entries " + value(entries)
+             + ", files " + value(files) + ", mode changes " + value(modeChanges) + " (already set " + value(modesKept)
+             + "), syscalls " + value(syscalls) + ", errors " + value(errors);
+    }
+};
+
+// Set the permission bits of name (relative to dirFd, AT_FDCWD for plain paths) to wanted, given the current mode
+// from an earlier stat. Returns 0 if they were already right (no system call), 1 if changed, -1 on failure (errno).
+// With noFollow the change is refused if name has been replaced by a symlink since it was stat()ed. C libraries
+// without AT_SYMLINK_NOFOLLOW support in fchmodat() report ENOTSUP; name is then checked again and changed by path.
+inline int changeMode(int dirFd, const char *name, mode_t current, mode_t wanted, walkCounters *counters = nullptr,
+                      bool noFollow = false) {
+    if ((current & 07777) == (wanted & 07777)) {
+        if (counters) { counters->add(counters->modesKept); }
+        return 0;
+    }
+    if (counters) { counters->add(counters->syscalls); }
+    if (fchmodat(dirFd, name, wanted & 07777, noFollow ? AT_SYMLINK_NOFOLLOW : 0) == -1) {
+        struct stat check;
+        if (!noFollow || (errno != ENOTSUP && errno != EOPNOTSUPP)) { return -1; }
+        if (fstatat(dirFd, name, &check, AT_SYMLINK_NOFOLLOW) == -1) { return -1; }
+        if (S_ISLNK(check.st_mode)) { errno = ELOOP; return -1; }
+        if (fchmodat(dirFd, name, wanted & 07777, 0) == -1) { return -1; }
+    }
+    if (counters) { counters->add(counters->modeChanges); }
+    return 1;
+}
+
+struct walkOptions {
+    unsigned jobs = 1; // Walker threads (0 = one per core); with 1 the walk runs on the calling thread only
+    bool followFileSymlinks = false; // Hand symlinks to regular files to the visitor (otherwise they are skipped)
+    bool followDirectorySymlinks = false; // Descend into symlinked directories (a directory is never walked twice)
+    walkCounters *counters = nullptr; // Optional instrumentation
+};
+
+// Callbacks of walkTree(); they are called from the walker threads, so they must be thread-safe when jobs != 1.
+struct walkVisitor {
+    // A regular file, or with followFileSymlinks a symlink to one (symlink = true, and fileStat is the target's; the
+    // target may lie outside the tree). name is relative to dirFd,
+    // which stays open for the duration of the call; path is the full path. Returns false if the file failed.
+    std::function<bool(int dirFd, const char *name, const std::string &path, const struct stat &fileStat, bool symlink)> file;
+    // Optional: called after a directory is opened and before it is read. Returning true (with the names of its
+    // subdirectories filled in) skips reading it.
+    std::function<bool(const std::string &path, const struct stat &dirStat, std::vector<std::string> &subdirectories)> reuse;
+    // Optional: called after a directory was read, with the names of its subdirectories; clean is false if reading
+    // it or handling any of its entries failed.
+    std::function<void(const std::string &path, const struct stat &dirStat, const std::vector<std::string> &subdirectories, bool clean)> finished;
+    // Messages for failures (counted in walkCounters::errors) and for skipped directories.
+    std::function<void(const std::string &message)> error;
+    std::function<void(const std::string &message)> warning;
+};
+
+// Walk the tree under root with a pool of workers sharing one queue of directories: each worker opens a directory
+// once, reads it with readdir() (getdents64 batches underneath), classifies entries by d_type (falling back to
+// fstatat() where the file system leaves it unknown), stats each regular file once relative to the directory fd and
+// queues the subdirectories. Symlinks are never followed unless asked for: symlinks to regular files only with
+// followFileSymlinks, symlinked directories only with followDirectorySymlinks. Directories are queued by path rather than by open fd, so wide trees cannot exhaust the
+// descriptor limit. The walk ends when the queue is empty and no worker is still reading.
+inline void walkTree(const std::string &root, const walkOptions &options, const walkVisitor &visitor) {
+    struct pendingDirectory {
+        std::string path;
+        bool mayFollow; // The root and followed symlinks are opened without O_NOFOLLOW
+    };
+
+    std::deque<pendingDirectory> pending{{root, true}};
+    std::set<std::pair<dev_t, ino_t>> visited; // Only used when following symlinks
+    size_t listing = 0; // Workers currently processing a directory
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    walkCounters *counters = options.counters;
+
+    auto count = [&](std::atomic<std::uint64_t> walkCounters::*counter, std::uint64_t amount = 1) {
+        if (counters) { counters->add(counters->*counter, amount); }
+    };
+    auto fail = [&](const std::string &message) {
+        count(&walkCounters::errors);
+        if (visitor.error) { visitor.error(message); }
+    };
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        for (;;) {
+            queueChanged.wait(lock, [&] { return !pending.empty() || listing == 0; });
+            if (pending.empty()) { return; } // Nothing queued and nobody left to queue more
+            pendingDirectory directory = std::move(pending.front());
+            pending.pop_front();
+            ++listing;
+            lock.unlock();
+
+            std::vector<std::pair<std::string, bool>> subdirectories; // Name and whether it is a followed symlink
+            std::string prefix = directory.path.back() == '/' ? directory.path : directory.path + '/';
+            int dirFd = open(directory.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC
+                             | (directory.mayFollow ? 0 : O_NOFOLLOW));
+            struct stat dirStat;
+            bool skip = false;
+            count(&walkCounters::syscalls, 2);
+            if (dirFd == -1) {
+                fail("Failed to open directory '" + directory.path + "': " + std::strerror(errno));
+                skip = true;
+            } else if (fstat(dirFd, &dirStat) == -1) {
+                fail("Failed to get directory status for '" + directory.path + "': " + std::strerror(errno));
+                close(dirFd);
+                skip = true;
+            } else if (options.followDirectorySymlinks) {
+                std::lock_guard<std::mutex> guard(queueMutex);
+                if (!visited.emplace(dirStat.st_dev, dirStat.st_ino).second) { // A followed link led back to it
+                    if (visitor.warning) { visitor.warning("Skipping directory already visited (symlink loop or second link) '" + directory.path + "'"); }
+                    close(dirFd);
+                    skip = true;
+                }
+            }
+            if (!skip) { count(&walkCounters::directories); }
+
+            std::vector<std::string> reusedNames;
+            if (!skip && visitor.reuse && visitor.reuse(directory.path, dirStat, reusedNames)) {
+                count(&walkCounters::reused);
+                for (auto &name : reusedNames) { subdirectories.emplace_back(std::move(name), options.followDirectorySymlinks); }
+                close(dirFd);
+                skip = true;
+            }
+
+            DIR *dir = skip ? nullptr : fdopendir(dirFd);
+            if (!skip && dir == nullptr) {
+                fail("Failed to read directory '" + directory.path + "': " + std::strerror(errno));
+                close(dirFd);
+            } else if (dir != nullptr) {
+                bool clean = true; // Every entry handled
+                std::vector<std::string> names; // Subdirectory names for visitor.finished
+                errno = 0;
+                while (struct dirent *entry = readdir(dir)) {
+                    const char *name = entry->d_name;
+                    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) { continue; }
+                    count(&walkCounters::entries);
+
+                    struct stat entryStat;
+                    unsigned char type = entry->d_type; // File type from the directory entry itself (no stat needed)
+                    bool haveStat = false;
+                    if (type == DT_UNKNOWN) { // Some file systems don't fill d_type
+                        count(&walkCounters::syscalls);
+                        if (fstatat(dirFd, name, &entryStat, AT_SYMLINK_NOFOLLOW) == -1) {
+                            if (errno != ENOENT) { fail("Failed to get file status for '" + prefix + name + "': " + std::strerror(errno)); clean = false; }
+                            errno = 0;
+                            continue;
+                        }
+                        type = S_ISLNK(entryStat.st_mode) ? DT_LNK : (S_ISDIR(entryStat.st_mode) ? DT_DIR
+                             : (S_ISREG(entryStat.st_mode) ? DT_REG : DT_UNKNOWN));
+                        haveStat = true;
+                    }
+
+                    bool symlink = type == DT_LNK;
+                    if (symlink) { // Classified by their target
+                        if (!options.followFileSymlinks && !options.followDirectorySymlinks) { errno = 0; continue; }
+                        count(&walkCounters::syscalls);
+                        if (fstatat(dirFd, name, &entryStat, 0) == -1) { errno = 0; continue; } // Dangling symlink
+                        type = S_ISDIR(entryStat.st_mode) ? DT_DIR : (S_ISREG(entryStat.st_mode) ? DT_REG : DT_UNKNOWN);
+                        haveStat = true;
+                        if (type == DT_DIR && !options.followDirectorySymlinks) { errno = 0; continue; }
+                        if (type == DT_REG && !options.followFileSymlinks) { errno = 0; continue; }
+                    }
+
+                    if (type == DT_DIR) {
+                        subdirectories.emplace_back(name, symlink);
+                        names.emplace_back(name);
+                    } else if (type == DT_REG) {
+                        if (!haveStat) {
+                            count(&walkCounters::syscalls);
+                            if (fstatat(dirFd, name, &entryStat, AT_SYMLINK_NOFOLLOW) == -1) { // The only stat of this inode
+                                if (errno != ENOENT) { fail("Failed to get file status for '" + prefix + name + "': " + std::strerror(errno)); clean = false; }
+                                errno = 0;
+                                continue;
+                            }
+                        }
+                        count(&walkCounters::files);
+                        if (!visitor.file(dirFd, name, prefix + name, entryStat, symlink)) { clean = false; }
+                    }
+                    errno = 0;
+                }
+                count(&walkCounters::syscalls, 2); // getdents64 and close
+                if (errno != 0) {
+                    fail("Failed to read directory '" + directory.path + "': " + std::strerror(errno));
+                    clean = false;
+                }
+                closedir(dir); // Also closes dirFd
+                if (visitor.finished) { visitor.finished(directory.path, dirStat, names, clean); }
+            }
+
+            lock.lock();
+            for (auto &subdirectory : subdirectories) {
+                pending.push_back({prefix + subdirectory.first, subdirectory.second});
+            }
+            --listing;
+            queueChanged.notify_all();
+        }
+    };
+
+    unsigned workers = options.jobs ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < workers; ++i) { pool.emplace_back(worker); }
+    worker();
+    for (auto &thread : pool) { thread.join(); }
+}
+
+#endif